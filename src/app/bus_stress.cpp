@@ -0,0 +1,677 @@
+#include "bus/publisher.hpp"
+#include "bus/subscriber.hpp"
+#include "bus/types.hpp"
+#include "bus/metrics.hpp"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+using namespace messenger;
+
+/**
+ * bus_stress runs a PublisherBus and one or more SubscriberBus instances in one
+ * process over loopback TCP, injects faults on a fixed schedule and reports
+ * per-stage loss and latency.
+ *
+ * Every payload carries "<steady_clock ns>|<message id>|", so each subscriber
+ * can tell delivered, dropped and duplicated messages apart. Which messages
+ * get a handler delay is a pure function of --seed and the message id, and
+ * pauses, reconnects and publisher restarts fire at fixed offsets from the
+ * start of the run.
+ */
+
+struct StressConfig {
+    int port = 5570;
+    int producers = 2;
+    int messages = 100000;  // per producer
+    int rate = 0;           // per producer, messages/sec; 0 = as fast as possible
+    int payload_size = 64;
+    size_t fragment_threshold = BusConfig{}.fragment_threshold;
+    size_t fragment_size = BusConfig{}.fragment_size;
+    int subscribers = 1;
+    int workers = 2;
+    int hwm = 10000;
+    size_t batch = 0;
+    uint64_t seed = 1;
+
+    // faults
+    int handler_delay_us = 0;
+    int delay_every = 1;          // delay one in N messages
+    int pause_pub_io_at_ms = -1;
+    int pause_pub_io_ms = 0;
+    int pause_sub_io_at_ms = -1;  // subscriber 0 only
+    int pause_sub_io_ms = 0;
+    int reconnect_every_ms = 0;   // subscriber 0 only
+    int restart_pub_every_ms = 0;
+
+    int settle_ms = 500;
+    bool strict = false;
+    std::string flight_dump;  // file prefix for flight recorder dumps at the end
+};
+
+// What one logical subscriber saw, across all of its reconnects
+struct Tally {
+    explicit Tally(size_t total) : seen(total), latency_ns(total, -1) {}
+
+    std::vector<std::atomic<uint8_t>> seen;  // indexed by message id
+    std::vector<int64_t> latency_ns;         // written once, by the first delivery
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> duplicated{0};
+    std::atomic<uint64_t> malformed{0};
+    int reconnects = 0;
+};
+
+// One logical subscriber; reconnects replace `bus` under `mutex`
+struct SubscriberSlot {
+    BusConfig config;
+    std::unique_ptr<Tally> tally;
+    Metrics::Stats stats;
+
+    std::mutex mutex;
+    std::unique_ptr<SubscriberBus> bus;  // null while reconnecting
+    bool io_paused = false;
+
+    // counters of instances torn down by reconnects
+    uint64_t retired_received = 0;
+    uint64_t retired_completed = 0;
+    uint64_t reconnect_window = 0;  // forwarded while this subscriber was disconnected
+};
+
+// The publisher; restarts replace `bus` under `mutex` while producers are parked
+struct PublisherSlot {
+    BusConfig config;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::unique_ptr<PublisherBus> bus;  // null while restarting
+    bool io_paused = false;
+    std::atomic<bool> restarting{false};
+    int producers = 0;  // producer threads still running
+    int parked = 0;     // producer threads waiting out a restart
+
+    uint64_t retired_forwarded = 0;  // by instances stopped by restarts
+    uint64_t restart_window = 0;     // forwarded before every subscriber resubscribed
+    int restarts = 0;
+};
+
+uint64_t mix64(uint64_t x) {
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void spin_for(std::chrono::microseconds duration) {
+    // busy-wait: sleep_for overshoots by tens of microseconds
+    const auto until = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < until) {
+    }
+}
+
+void on_message(Tally& tally, const StressConfig& cfg, std::string_view payload) {
+    const int64_t now_ns = steady_now_ns();
+
+    // "<ts>|<id>|<padding>"
+    const size_t first = payload.find('|');
+    const size_t second = first == std::string_view::npos ? first : payload.find('|', first + 1);
+    int64_t ts = 0;
+    uint64_t id = 0;
+    if (second == std::string_view::npos
+        || std::from_chars(payload.data(), payload.data() + first, ts).ec != std::errc()
+        || std::from_chars(payload.data() + first + 1, payload.data() + second, id).ec != std::errc()
+        || id >= tally.seen.size()) {
+        tally.malformed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (tally.seen[id].exchange(1, std::memory_order_relaxed) != 0) {
+        tally.duplicated.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        tally.latency_ns[id] = now_ns - ts;
+        tally.delivered.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (cfg.handler_delay_us > 0 && mix64(cfg.seed ^ id) % static_cast<uint64_t>(cfg.delay_every) == 0) {
+        spin_for(std::chrono::microseconds(cfg.handler_delay_us));
+    }
+}
+
+std::unique_ptr<SubscriberBus> make_subscriber(SubscriberSlot& slot, const StressConfig& cfg) {
+    Tally& tally = *slot.tally;
+    const std::vector<std::string> topics = {"stress"};
+
+    if (cfg.batch > 0) {
+        return std::make_unique<SubscriberBus>(slot.config, topics,
+            BatchHandler([&tally, &cfg](std::span<const MessageView> batch) {
+                for (const auto& msg : batch) {
+                    on_message(tally, cfg, msg.payload);
+                }
+            }));
+    }
+    return std::make_unique<SubscriberBus>(slot.config, topics,
+        MessageHandler([&tally, &cfg](const Message& msg) {
+            on_message(tally, cfg, msg.payload);
+        }));
+}
+
+uint64_t forwarded_total(PublisherSlot& pub) {
+    std::lock_guard<std::mutex> lock(pub.mutex);
+    return pub.retired_forwarded + (pub.bus ? pub.bus->forwarded_messages() : 0);
+}
+
+// Releases the producer handle and blocks until the restart finished
+void park_producer(PublisherSlot& pub, std::optional<Producer>& producer) {
+    producer.reset();
+    std::unique_lock<std::mutex> lock(pub.mutex);
+    ++pub.parked;
+    pub.changed.notify_all();
+    pub.changed.wait(lock, [&pub]() { return !pub.restarting.load(); });
+    --pub.parked;
+}
+
+void producer_thread(PublisherSlot& pub,
+                     const StressConfig& cfg,
+                     int tid,
+                     std::atomic<uint64_t>& refused_messages,
+                     std::atomic<uint64_t>& restart_refused_messages) {
+    std::optional<Producer> producer;
+    const std::string topic = "stress" + std::to_string(tid);
+    const auto period = cfg.rate > 0 ? std::chrono::nanoseconds(1000000000LL / cfg.rate) : std::chrono::nanoseconds(0);
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t refused = 0;
+    uint64_t restart_refused = 0;
+    std::string payload;
+
+    for (int i = 0; i < cfg.messages; ++i) {
+        if (cfg.rate > 0) {
+            // fixed schedule, so a stall is followed by a catch-up burst as in production
+            const auto due = start + period * i;
+            while (std::chrono::steady_clock::now() < due) {
+                std::this_thread::yield();
+            }
+        }
+
+        // a Producer must not outlive its PublisherBus, so restarts wait for every handle
+        if (pub.restarting.load(std::memory_order_acquire)) {
+            park_producer(pub, producer);
+        }
+        if (!producer) {
+            std::lock_guard<std::mutex> lock(pub.mutex);
+            producer.emplace(pub.bus->make_producer());
+        }
+
+        const uint64_t id = static_cast<uint64_t>(tid) * cfg.messages + i;
+        payload = std::to_string(steady_now_ns()) + "|" + std::to_string(id) + "|";
+        if (payload.size() < static_cast<size_t>(cfg.payload_size)) {
+            payload.resize(cfg.payload_size, 'x');
+        }
+
+        if (!producer->produce(topic, payload)) {
+            // a restart closes producers before this thread notices it
+            ++(pub.restarting.load() ? restart_refused : refused);
+        }
+    }
+
+    producer.reset();
+    refused_messages.fetch_add(refused, std::memory_order_relaxed);
+    restart_refused_messages.fetch_add(restart_refused, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(pub.mutex);
+    --pub.producers;
+    pub.changed.notify_all();
+}
+
+void set_publisher_paused(PublisherSlot& pub, bool paused) {
+    std::lock_guard<std::mutex> lock(pub.mutex);
+    pub.io_paused = paused;
+    // a restarting bus must keep draining; the fresh one picks up io_paused
+    if (pub.bus && !pub.restarting.load(std::memory_order_relaxed)) {
+        pub.bus->set_io_paused(paused);
+    }
+}
+
+void set_subscriber_paused(SubscriberSlot& slot, bool paused) {
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    slot.io_paused = paused;
+    if (slot.bus) {
+        slot.bus->set_io_paused(paused);
+    }
+}
+
+// Same subscriber id, fresh sockets; whatever was in flight is lost
+void reconnect_subscriber(PublisherSlot& pub, SubscriberSlot& slot, const StressConfig& cfg) {
+    std::unique_ptr<SubscriberBus> old;
+    {
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        old = std::move(slot.bus);
+    }
+    // out of the slot, so no pause reaches it any more; let stop() run freely
+    old->set_io_paused(false);
+    old->stop();
+    const uint64_t disconnected_at = forwarded_total(pub);
+    const uint64_t received = old->received_messages();
+    const uint64_t completed = old->completed_messages();
+    old.reset();
+
+    auto fresh = make_subscriber(slot, cfg);
+    fresh->start();
+    const uint64_t window = forwarded_total(pub) - disconnected_at;
+
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    fresh->set_io_paused(slot.io_paused);
+    slot.bus = std::move(fresh);
+    slot.retired_received += received;
+    slot.retired_completed += completed;
+    slot.reconnect_window += window;
+    ++slot.tally->reconnects;
+}
+
+// Stops the publisher and brings up a new one on the same addresses, as a
+// deploy would. Producers drop their handles and re-create them afterwards
+void restart_publisher(PublisherSlot& pub, size_t subscribers) {
+    std::unique_ptr<PublisherBus> old;
+    {
+        std::unique_lock<std::mutex> lock(pub.mutex);
+        pub.restarting.store(true, std::memory_order_release);
+        // produce() calls from here on fail, as they would against a dying publisher
+        pub.bus->close_producers();
+        // stop() drains ingress, which a paused I/O thread never would
+        pub.bus->set_io_paused(false);
+        pub.changed.wait(lock, [&pub]() { return pub.parked == pub.producers; });
+        old = std::move(pub.bus);
+    }
+    // stop() waits for ingress to drain, which needs a running I/O thread
+    old->set_io_paused(false);
+    old->stop();
+    const uint64_t forwarded = old->forwarded_messages();
+    old.reset();  // unbinds the addresses
+
+    auto fresh = std::make_unique<PublisherBus>(pub.config);
+    fresh->start();
+    PublisherBus& bus = *fresh;
+    {
+        std::lock_guard<std::mutex> lock(pub.mutex);
+        fresh->set_io_paused(pub.io_paused);
+        pub.bus = std::move(fresh);
+        pub.retired_forwarded += forwarded;
+        ++pub.restarts;
+        pub.restarting.store(false, std::memory_order_release);
+    }
+    pub.changed.notify_all();
+
+    // subscribers reconnect on their own; until each resubscribed, the new
+    // XPUB drops its messages. Only this thread replaces the bus
+    bus.wait_for_subscribers(subscribers, std::chrono::milliseconds(5000));
+    const uint64_t window = bus.forwarded_messages();
+
+    std::lock_guard<std::mutex> lock(pub.mutex);
+    pub.restart_window += window;
+}
+
+// Applies pauses until production finished and no pause is active
+void pause_thread(PublisherSlot& pub,
+                  SubscriberSlot& slot,
+                  const StressConfig& cfg,
+                  std::chrono::steady_clock::time_point start,
+                  const std::atomic<bool>& producing) {
+    bool pub_paused = false;
+    bool sub_paused = false;
+
+    auto in_window = [](int64_t now_ms, int at_ms, int duration_ms) {
+        return at_ms >= 0 && now_ms >= at_ms && now_ms < at_ms + duration_ms;
+    };
+
+    while (producing.load() || pub_paused || sub_paused) {
+        const int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        const bool pub_pause = in_window(now_ms, cfg.pause_pub_io_at_ms, cfg.pause_pub_io_ms);
+        if (pub_pause != pub_paused) {
+            set_publisher_paused(pub, pub_pause);
+            pub_paused = pub_pause;
+        }
+
+        const bool sub_pause = in_window(now_ms, cfg.pause_sub_io_at_ms, cfg.pause_sub_io_ms);
+        if (sub_pause != sub_paused) {
+            set_subscriber_paused(slot, sub_pause);
+            sub_paused = sub_pause;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Applies reconnects and publisher restarts while producing. Both block
+// until the readiness handshake completes, so they run on their own thread
+// and never delay the pause schedule
+void churn_thread(PublisherSlot& pub,
+                  SubscriberSlot& slot,
+                  const StressConfig& cfg,
+                  std::chrono::steady_clock::time_point start,
+                  const std::atomic<bool>& producing) {
+    int64_t next_reconnect_ms = cfg.reconnect_every_ms;
+    int64_t next_restart_ms = cfg.restart_pub_every_ms;
+
+    auto due = [](int64_t now_ms, int every_ms, int64_t& next_ms) {
+        if (every_ms <= 0 || now_ms < next_ms) {
+            return false;
+        }
+        // skip slots missed while a slow reconnect or restart ran
+        while (next_ms <= now_ms) {
+            next_ms += every_ms;
+        }
+        return true;
+    };
+
+    while (producing.load()) {
+        const int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        if (due(now_ms, cfg.restart_pub_every_ms, next_restart_ms)) {
+            restart_publisher(pub, static_cast<size_t>(cfg.subscribers));
+        }
+        if (due(now_ms, cfg.reconnect_every_ms, next_reconnect_ms)) {
+            reconnect_subscriber(pub, slot, cfg);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Splits "<at_ms>:<duration_ms>"
+bool parse_window(const std::string& spec, int& at_ms, int& duration_ms) {
+    const size_t colon = spec.find(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+    at_ms = std::atoi(spec.substr(0, colon).c_str());
+    duration_ms = std::atoi(spec.substr(colon + 1).c_str());
+    return at_ms >= 0 && duration_ms > 0;
+}
+
+std::string format_latencies(const Tally& tally) {
+    std::vector<int64_t> latencies;
+    latencies.reserve(tally.delivered.load());
+    for (int64_t latency : tally.latency_ns) {
+        if (latency >= 0) {
+            latencies.push_back(latency);
+        }
+    }
+    if (latencies.empty()) {
+        return "none";
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    auto at = [&latencies](double q) {
+        const size_t index = std::min(latencies.size() - 1, static_cast<size_t>(q * latencies.size()));
+        return metrics_utils::format_duration(std::chrono::nanoseconds(latencies[index]));
+    };
+    return "p50=" + at(0.50) + " p90=" + at(0.90) + " p99=" + at(0.99) + " p999=" + at(0.999)
+        + " max=" + metrics_utils::format_duration(std::chrono::nanoseconds(latencies.back()));
+}
+
+int main(int argc, char* argv[]) {
+    StressConfig cfg;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--strict") {
+            cfg.strict = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        const std::string value = argv[++i];
+
+        if (arg == "--port") {
+            cfg.port = std::atoi(value.c_str());
+        }
+        else if (arg == "--producers") {
+            cfg.producers = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (arg == "--messages") {
+            cfg.messages = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (arg == "--rate") {
+            cfg.rate = std::max(0, std::atoi(value.c_str()));
+        }
+        else if (arg == "--payload") {
+            cfg.payload_size = std::max(0, std::atoi(value.c_str()));
+        }
+        else if (arg == "--fragment-threshold") {
+            cfg.fragment_threshold = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (arg == "--fragment-size") {
+            cfg.fragment_size = std::max<size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+        }
+        else if (arg == "--subscribers") {
+            cfg.subscribers = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (arg == "--workers") {
+            cfg.workers = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (arg == "--hwm") {
+            cfg.hwm = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (arg == "--batch") {
+            cfg.batch = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (arg == "--seed") {
+            cfg.seed = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (arg == "--handler-delay-us") {
+            cfg.handler_delay_us = std::max(0, std::atoi(value.c_str()));
+        }
+        else if (arg == "--delay-every") {
+            cfg.delay_every = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (arg == "--pause-pub-io") {
+            if (!parse_window(value, cfg.pause_pub_io_at_ms, cfg.pause_pub_io_ms)) {
+                std::cerr << "Invalid --pause-pub-io (expected <at_ms>:<duration_ms>): " << value << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--pause-sub-io") {
+            if (!parse_window(value, cfg.pause_sub_io_at_ms, cfg.pause_sub_io_ms)) {
+                std::cerr << "Invalid --pause-sub-io (expected <at_ms>:<duration_ms>): " << value << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--reconnect-every-ms") {
+            cfg.reconnect_every_ms = std::max(0, std::atoi(value.c_str()));
+        }
+        else if (arg == "--restart-pub-every-ms") {
+            cfg.restart_pub_every_ms = std::max(0, std::atoi(value.c_str()));
+        }
+        else if (arg == "--settle-ms") {
+            cfg.settle_ms = std::max(0, std::atoi(value.c_str()));
+        }
+        else if (arg == "--flight-dump") {
+            cfg.flight_dump = value;
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    const uint64_t total = static_cast<uint64_t>(cfg.producers) * cfg.messages;
+
+    std::cout << "CONFIG: producers=" << cfg.producers << " messages=" << cfg.messages
+              << " rate=" << cfg.rate << " payload=" << cfg.payload_size
+              << " fragment=" << cfg.fragment_threshold << "/" << cfg.fragment_size
+              << " subscribers=" << cfg.subscribers << " workers=" << cfg.workers
+              << " hwm=" << cfg.hwm << " batch=" << cfg.batch << " seed=" << cfg.seed
+              << " handler_delay_us=" << cfg.handler_delay_us << " delay_every=" << cfg.delay_every
+              << " pause_pub_io=" << cfg.pause_pub_io_at_ms << ":" << cfg.pause_pub_io_ms
+              << " pause_sub_io=" << cfg.pause_sub_io_at_ms << ":" << cfg.pause_sub_io_ms
+              << " reconnect_every_ms=" << cfg.reconnect_every_ms
+              << " restart_pub_every_ms=" << cfg.restart_pub_every_ms << std::endl;
+
+    PublisherSlot pub;
+    pub.config.pub_bind_addr = "tcp://127.0.0.1:" + std::to_string(cfg.port);
+    pub.config.hwm = cfg.hwm;
+    pub.config.fragment_threshold = cfg.fragment_threshold;
+    pub.config.fragment_size = cfg.fragment_size;
+    pub.producers = cfg.producers;
+
+    pub.bus = std::make_unique<PublisherBus>(pub.config);
+    pub.bus->start();
+
+    std::vector<std::unique_ptr<SubscriberSlot>> slots;
+    for (int i = 0; i < cfg.subscribers; ++i) {
+        auto slot = std::make_unique<SubscriberSlot>();
+        slot->config.sub_connect_addr = "tcp://127.0.0.1:" + std::to_string(cfg.port);
+        slot->config.subscriber_id = "stress-sub-" + std::to_string(i);
+        slot->config.worker_threads = cfg.workers;
+        slot->config.hwm = cfg.hwm;
+        // reconnects must be live again before the loss window closes
+        slot->config.await_ready = true;
+        slot->config.ready_timeout = std::chrono::milliseconds(5000);
+        if (cfg.batch > 0) {
+            slot->config.batch_max_messages = cfg.batch;
+        }
+        // window covers the whole run; the stage ring still keeps only the latest
+        // Metrics::kStageSampleCapacity messages
+        slot->config.metrics_period = std::chrono::minutes(10);
+        slot->tally = std::make_unique<Tally>(total);
+        slot->bus = make_subscriber(*slot, cfg);
+        slot->bus->start();
+        slots.push_back(std::move(slot));
+    }
+
+    if (!pub.bus->wait_for_subscribers(static_cast<size_t>(cfg.subscribers), std::chrono::milliseconds(5000))) {
+        std::cerr << "Only " << pub.bus->ready_subscribers() << " of " << cfg.subscribers
+                  << " subscribers ready" << std::endl;
+        return 1;
+    }
+
+    std::atomic<bool> producing{true};
+    std::atomic<uint64_t> refused_messages{0};
+    std::atomic<uint64_t> restart_refused_messages{0};
+    const auto start_time = std::chrono::steady_clock::now();
+    std::thread pauses(pause_thread, std::ref(pub), std::ref(*slots.front()), std::cref(cfg), start_time,
+                       std::cref(producing));
+    std::thread churn(churn_thread, std::ref(pub), std::ref(*slots.front()), std::cref(cfg), start_time,
+                      std::cref(producing));
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < cfg.producers; ++i) {
+        producers.emplace_back(producer_thread, std::ref(pub), std::cref(cfg), i, std::ref(refused_messages),
+                               std::ref(restart_refused_messages));
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    const auto produce_time = std::chrono::steady_clock::now() - start_time;
+
+    producing.store(false);
+    pauses.join();
+    churn.join();
+
+    PublisherBus& publisher = *pub.bus;
+    publisher.close_producers();
+    const bool drained = publisher.wait_drained(std::chrono::milliseconds(10000));
+    const uint64_t forwarded = forwarded_total(pub);
+
+    // wait until every subscriber has everything, or stopped making progress
+    auto delivered_sum = [&slots]() {
+        uint64_t sum = 0;
+        for (const auto& slot : slots) {
+            sum += slot->tally->delivered.load() + slot->tally->duplicated.load();
+        }
+        return sum;
+    };
+    uint64_t last_sum = delivered_sum();
+    auto last_progress = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - last_progress < std::chrono::milliseconds(cfg.settle_ms)) {
+        bool complete = true;
+        for (const auto& slot : slots) {
+            complete &= slot->tally->delivered.load() >= forwarded;
+        }
+        if (complete) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const uint64_t sum = delivered_sum();
+        if (sum != last_sum) {
+            last_sum = sum;
+            last_progress = std::chrono::steady_clock::now();
+        }
+    }
+
+    for (auto& slot : slots) {
+        slot->stats = slot->bus->get_metrics();
+        slot->bus->stop();
+    }
+    publisher.stop();
+    
+    if (!cfg.flight_dump.empty()) {
+        publisher.dump_flight_recorder(cfg.flight_dump + ".publisher.bin");
+        for (size_t i = 0; i < slots.size(); ++i) {
+            slots[i]->bus->dump_flight_recorder(cfg.flight_dump + ".sub" + std::to_string(i) + ".bin");
+        }
+    }
+
+    const uint64_t refused = refused_messages.load();
+    const uint64_t restart_refused = restart_refused_messages.load();
+    const uint64_t accepted = total - refused - restart_refused;
+    bool lossless = refused == 0 && restart_refused == 0 && forwarded == accepted;
+
+    std::cout << "PRODUCE: attempted=" << total << " accepted=" << accepted << " refused=" << refused
+              << " restart_refused=" << restart_refused
+              << " time=" << std::chrono::duration_cast<std::chrono::milliseconds>(produce_time).count() << "ms"
+              << std::endl;
+    std::cout << "FORWARD: forwarded=" << forwarded << " unforwarded=" << (accepted - std::min(accepted, forwarded))
+              << " restarts=" << pub.restarts << (drained ? "" : " (drain timed out)") << std::endl;
+
+    for (size_t i = 0; i < slots.size(); ++i) {
+        const SubscriberSlot& slot = *slots[i];
+        const Tally& tally = *slot.tally;
+        const uint64_t received = slot.retired_received + slot.bus->received_messages();
+        const uint64_t completed = slot.retired_completed + slot.bus->completed_messages();
+        const uint64_t delivered = tally.delivered.load();
+        const uint64_t duplicated = tally.duplicated.load();
+        lossless &= delivered == forwarded && duplicated == 0 && tally.malformed.load() == 0;
+
+        // forwarded but never read: the reconnect and restart windows count
+        // messages forwarded while this subscriber could not have received
+        // them, the rest was dropped at an HWM or in TCP
+        const uint64_t transport = forwarded - std::min(forwarded, received);
+        const uint64_t reconnect_gap = std::min(slot.reconnect_window, transport);
+        const uint64_t restart_gap = std::min(pub.restart_window, transport - reconnect_gap);
+        const uint64_t hwm = transport - reconnect_gap - restart_gap;
+
+        std::cout << "SUB " << i << ": received=" << received << " completed=" << completed
+                  << " delivered=" << delivered << " duplicated=" << duplicated
+                  << " malformed=" << tally.malformed.load()
+                  << " reconnects=" << tally.reconnects << std::endl;
+        std::cout << "SUB " << i << " LOSS: transport=" << transport << " (hwm=" << hwm
+                  << " reconnect=" << reconnect_gap << " restart=" << restart_gap << ")"
+                  << " in_subscriber=" << (received - std::min(received, completed)) << std::endl;
+        std::cout << "SUB " << i << " LATENCY: " << format_latencies(tally) << std::endl;
+        std::cout << "SUB " << i << " STAGES: " << metrics_utils::format_stage_stats(slot.stats) << std::endl;
+    }
+
+    std::cout << "RESULT: " << (lossless ? "lossless" : "lossy") << std::endl;
+    return cfg.strict && !lossless ? 2 : 0;
+}
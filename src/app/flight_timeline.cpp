@@ -0,0 +1,230 @@
+#include "bus/flight_recorder.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace messenger;
+
+/**
+ * flight_timeline turns FlightRecorder dumps into per-message timelines.
+ *
+ * Pass the publisher's and the subscribers' dumps together. Events are joined
+ * by message id (the produce TSC stamp), so the dumps must come from processes
+ * on the same host.
+ */
+
+struct Dump {
+    std::string name;
+    FlightDumpHeader header;
+    std::vector<FlightEvent> events;
+};
+
+struct TimelineEvent {
+    FlightEvent event;
+    const Dump* dump;
+};
+
+bool read_dump(const std::string& path, Dump& dump) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.read(reinterpret_cast<char*>(&dump.header), sizeof(dump.header))) {
+        std::cerr << path << ": truncated header" << std::endl;
+        return false;
+    }
+    if (std::memcmp(dump.header.magic, kFlightDumpMagic, sizeof(kFlightDumpMagic)) != 0
+        || dump.header.version != kFlightDumpVersion
+        || dump.header.event_size != sizeof(FlightEvent)) {
+        std::cerr << path << ": not a flight recorder dump (or another version)" << std::endl;
+        return false;
+    }
+
+    dump.events.resize(dump.header.event_count);
+    if (!in.read(reinterpret_cast<char*>(dump.events.data()),
+                 static_cast<std::streamsize>(dump.events.size() * sizeof(FlightEvent)))) {
+        std::cerr << path << ": truncated events" << std::endl;
+        return false;
+    }
+
+    dump.name = std::string(dump.header.name, strnlen(dump.header.name, sizeof(dump.header.name)));
+    return true;
+}
+
+const char* event_name(uint16_t type) {
+    switch (static_cast<FlightEventType>(type)) {
+        case FlightEventType::Produce: return "produce";
+        case FlightEventType::Forward: return "forward";
+        case FlightEventType::Receive: return "receive";
+        case FlightEventType::Dispatch: return "dispatch";
+        case FlightEventType::HandlerStart: return "handler_start";
+        case FlightEventType::HandlerEnd: return "handler_end";
+        case FlightEventType::Drop: return "drop";
+    }
+    return "unknown";
+}
+
+const char* drop_reason(uint64_t reason) {
+    switch (static_cast<DropReason>(reason)) {
+        case DropReason::Closed: return "closed";
+        case DropReason::FlowControl: return "flow_control";
+        case DropReason::SendFailed: return "send_failed";
+        case DropReason::Incomplete: return "incomplete";
+        case DropReason::Oversized: return "oversized";
+    }
+    return "unknown";
+}
+
+void print_event(const TimelineEvent& item, uint64_t origin_ticks, double ns_per_tick) {
+    const FlightEvent& event = item.event;
+    const double offset_us = static_cast<double>(event.ticks - origin_ticks) * ns_per_tick / 1000.0;
+
+    std::cout << "  +" << std::fixed << std::setprecision(3) << std::setw(12) << offset_us << "us  "
+              << std::left << std::setw(14) << event_name(event.type) << std::right
+              << item.dump->name << " t" << event.thread;
+
+    switch (static_cast<FlightEventType>(event.type)) {
+        case FlightEventType::Produce:
+        case FlightEventType::Forward:
+        case FlightEventType::Receive:
+            std::cout << " lane" << event.lane << " size=" << event.aux;
+            break;
+        case FlightEventType::Dispatch:
+            std::cout << " lane" << event.lane;
+            [[fallthrough]];
+        case FlightEventType::HandlerStart:
+        case FlightEventType::HandlerEnd:
+            if (event.aux > 0) {
+                std::cout << " batch=" << event.aux;
+            }
+            break;
+        case FlightEventType::Drop:
+            std::cout << " reason=" << drop_reason(event.aux);
+            break;
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    size_t slowest = 20;
+    bool all = false;
+    uint64_t only_message = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--all") {
+            all = true;
+        }
+        else if (arg == "--slowest" && i + 1 < argc) {
+            slowest = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--message" && i + 1 < argc) {
+            only_message = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <dump>... [--slowest N | --all | --message ID]" << std::endl;
+        return 1;
+    }
+
+    std::vector<Dump> dumps(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!read_dump(paths[i], dumps[i])) {
+            return 1;
+        }
+    }
+
+    // all dumps come from one host, so they share one TSC calibration
+    const double ns_per_tick = dumps.front().header.ns_per_tick;
+
+    std::map<uint64_t, std::vector<TimelineEvent>> messages;
+    std::vector<TimelineEvent> drops;  // drops without a message id
+    size_t drop_count = 0;
+    size_t uncorrelated = 0;
+    uint64_t first_ticks = UINT64_MAX;
+    uint64_t last_ticks = 0;
+
+    for (const auto& dump : dumps) {
+        std::cout << "DUMP: " << dump.name << " pid=" << dump.header.pid
+                  << " threads=" << dump.header.thread_count
+                  << " events=" << dump.header.event_count << std::endl;
+
+        for (const auto& event : dump.events) {
+            first_ticks = std::min(first_ticks, event.ticks);
+            last_ticks = std::max(last_ticks, event.ticks);
+
+            const bool drop = event.type == static_cast<uint16_t>(FlightEventType::Drop);
+            drop_count += drop;
+            if (drop && event.message_id == 0) {
+                drops.push_back({event, &dump});
+            } else if (event.message_id == 0) {
+                ++uncorrelated;
+            } else {
+                messages[event.message_id].push_back({event, &dump});
+            }
+        }
+    }
+
+    if (first_ticks <= last_ticks) {
+        std::cout << "SPAN: " << std::fixed << std::setprecision(3)
+                  << static_cast<double>(last_ticks - first_ticks) * ns_per_tick / 1e6 << "ms"
+                  << " messages=" << messages.size() << " drops=" << drop_count
+                  << " uncorrelated=" << uncorrelated << std::endl;
+    }
+
+    auto by_ticks = [](const TimelineEvent& a, const TimelineEvent& b) { return a.event.ticks < b.event.ticks; };
+    for (auto& [id, events] : messages) {
+        std::stable_sort(events.begin(), events.end(), by_ticks);
+    }
+
+    // message ids are produce stamps, so map order is produce order
+    std::vector<const std::pair<const uint64_t, std::vector<TimelineEvent>>*> selected;
+    for (const auto& entry : messages) {
+        if (only_message == 0 || entry.first == only_message) {
+            selected.push_back(&entry);
+        }
+    }
+    if (!all && only_message == 0) {
+        auto span = [](const std::vector<TimelineEvent>& events) {
+            return events.back().event.ticks - events.front().event.ticks;
+        };
+        std::stable_sort(selected.begin(), selected.end(), [&span](const auto* a, const auto* b) {
+            return span(a->second) > span(b->second);
+        });
+        if (selected.size() > slowest) {
+            selected.resize(slowest);
+        }
+    }
+
+    for (const auto* entry : selected) {
+        const auto& events = entry->second;
+        const uint64_t origin = events.front().event.ticks;
+        const double span_us = static_cast<double>(events.back().event.ticks - origin) * ns_per_tick / 1000.0;
+
+        // events older than a ring's window are gone, so a timeline can start late
+        const bool complete = events.front().event.type == static_cast<uint16_t>(FlightEventType::Produce);
+
+        std::cout << std::endl << "MESSAGE " << entry->first << " span=" << std::fixed << std::setprecision(3)
+                  << span_us << "us" << (complete ? "" : " (partial)") << std::endl;
+        for (const auto& item : events) {
+            print_event(item, origin, ns_per_tick);
+        }
+    }
+
+    if (!drops.empty()) {
+        std::cout << std::endl << "DROPS (no message id):" << std::endl;
+        for (const auto& item : drops) {
+            print_event(item, first_ticks, ns_per_tick);
+        }
+    }
+
+    return 0;
+}
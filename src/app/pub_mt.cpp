@@ -1,11 +1,14 @@
 #include "bus/publisher.hpp"
+#include "bus/lanes.hpp"
 #include "bus/types.hpp"
+#include "bus/flight_recorder.hpp"
 #include <iostream>
 #include <thread>
 #include <vector>
 #include <chrono>
 #include <atomic>
 #include <cstring>
+#include <csignal>
 
 using namespace messenger;
 
@@ -14,6 +17,9 @@ void producer_thread(PublisherBus& bus,
                      int msg_count,
                      const std::string& topic_prefix,
                      std::atomic<uint64_t>& rejected_messages) {
+    Producer producer = bus.make_producer();
+    uint64_t rejected = 0;
+    
     for (int i = 0; i < msg_count; ++i) {
         auto now = std::chrono::steady_clock::now();
         auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
@@ -24,10 +30,12 @@ void producer_thread(PublisherBus& bus,
         std::string topic = topic_prefix + std::to_string(tid % 4);
         Message msg(topic, payload);
         
-        if (!bus.produce(msg)) {
-            rejected_messages.fetch_add(1, std::memory_order_relaxed);
+        if (!producer.produce(msg)) {
+            ++rejected;
         }
     }
+    
+    rejected_messages.fetch_add(rejected, std::memory_order_relaxed);
 }
 
 int main(int argc, char* argv[]) {
@@ -36,6 +44,10 @@ int main(int argc, char* argv[]) {
     int messages_per_producer = 10000;
     std::string topic_prefix = "topic";
     int hwm = 10000;
+    int await_subscribers = 0;
+    int ready_timeout_ms = 5000;
+    std::vector<PriorityLane> lanes;
+    FlowControlMode flow_control = FlowControlMode::None;
     
     for (int i = 1; i < argc; i += 2) {
         if (i + 1 >= argc) break;
@@ -56,6 +68,33 @@ int main(int argc, char* argv[]) {
         else if (arg == "--hwm" && i + 1 < argc) {
             hwm = std::atoi(argv[i + 1]);
         }
+        else if (arg == "--await-subs" && i + 1 < argc) {
+            await_subscribers = std::atoi(argv[i + 1]);
+        }
+        else if (arg == "--ready-timeout-ms" && i + 1 < argc) {
+            ready_timeout_ms = std::atoi(argv[i + 1]);
+        }
+        else if (arg == "--flow-control" && i + 1 < argc) {
+            std::string mode = argv[i + 1];
+            if (mode == "none") {
+                flow_control = FlowControlMode::None;
+            } else if (mode == "throttle") {
+                flow_control = FlowControlMode::Throttle;
+            } else if (mode == "reject") {
+                flow_control = FlowControlMode::Reject;
+            } else {
+                std::cerr << "Unknown flow control mode: " << mode << " (expected none, throttle or reject)" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--lane" && i + 1 < argc) {
+            PriorityLane lane;
+            if (!parse_lane_spec(argv[i + 1], lane.topic_prefixes, lane.pub_bind_addr)) {
+                std::cerr << "Invalid --lane (expected prefix[,prefix...]@address): " << argv[i + 1] << std::endl;
+                return 1;
+            }
+            lanes.push_back(lane);
+        }
     }
     
     std::cout << "Starting multithreaded publisher:" << std::endl;
@@ -65,15 +104,31 @@ int main(int argc, char* argv[]) {
     std::cout << "  Publisher address: " << pub_addr << std::endl;
     std::cout << "  Topic prefix: " << topic_prefix << std::endl;
     std::cout << "  HWM: " << hwm << std::endl;
+    std::cout << "  Await subscribers: " << await_subscribers << std::endl;
+    for (size_t lane = 0; lane < lanes.size(); ++lane) {
+        std::cout << "  Priority lane " << lane << ": " << lanes[lane].pub_bind_addr << std::endl;
+    }
     std::cout << std::endl;
     
     BusConfig config;
     config.pub_bind_addr = pub_addr;
     config.worker_threads = 1; 
     config.hwm = hwm;
+    config.await_subscribers = static_cast<size_t>(await_subscribers);
+    config.ready_timeout = std::chrono::milliseconds(ready_timeout_ms);
+    config.priority_lanes = lanes;
+    config.flow_control = flow_control;
+    
+    // kill -USR1 <pid> dumps the flight recorder (see README)
+    FlightRecorder::install_signal_handler(SIGUSR1);
     
     PublisherBus bus(config);
     bus.start();
+    
+    if (bus.ready_subscribers() < config.await_subscribers) {
+        std::cout << "Warning: only " << bus.ready_subscribers() << " of " << await_subscribers
+                  << " subscribers ready after " << ready_timeout_ms << " ms" << std::endl;
+    }
 
     std::vector<std::thread> producers;
     std::atomic<uint64_t> rejected_messages{0};
@@ -107,6 +162,19 @@ int main(int argc, char* argv[]) {
     }
 
     std::cout << "Rejected produces: " << rejected_messages.load(std::memory_order_relaxed) << std::endl;
+    
+    if (flow_control != FlowControlMode::None) {
+        auto state = bus.flow_control_state();
+        std::cout << "Flow control: throttled=" << state.throttled_produces
+                  << " rejected=" << state.rejected_produces << std::endl;
+        for (const auto& subscriber : state.subscribers) {
+            std::cout << "  subscriber " << subscriber.subscriber_id
+                      << " credit=" << subscriber.credit
+                      << " sent=" << subscriber.sent
+                      << " lost=" << subscriber.lost
+                      << (subscriber.blocked ? " BLOCKED" : "") << std::endl;
+        }
+    }
 
     bus.stop();
     std::cout << "Publisher stopped" << std::endl;
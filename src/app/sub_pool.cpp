@@ -1,10 +1,14 @@
 #include "bus/subscriber.hpp"
+#include "bus/lanes.hpp"
 #include "bus/types.hpp"
 #include "bus/metrics.hpp"
+#include "bus/flight_recorder.hpp"
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <algorithm>
+#include <cstdlib>
 #include <signal.h>
 
 using namespace messenger;
@@ -17,11 +21,13 @@ void signal_handler(int signal) {
     }
 }
 
-void simulate_handler_work() {
-    // simulate some CPU work (0.5-1ms)
-    int total = 0;
-    for (int i = 0; i < 10000; ++i) {
-        total += i * i;
+void simulate_handler_work(int rounds) {
+    // simulate some CPU work (0.5-1ms per round)
+    for (int round = 0; round < rounds; ++round) {
+        int total = 0;
+        for (int i = 0; i < 10000; ++i) {
+            total += i * i;
+        }
     }
 }
 
@@ -31,6 +37,7 @@ void metrics_thread(SubscriberBus& bus) {
         
         auto stats = bus.get_metrics();
         std::cout << "METRICS: " << metrics_utils::format_stats(stats) << std::endl;
+        std::cout << "STAGES: " << metrics_utils::format_stage_stats(stats) << std::endl;
     }
 }
 
@@ -39,6 +46,11 @@ int main(int argc, char* argv[]) {
     int num_workers = 4;
     int hwm = 10000;
     bool simulate_work = true;
+    int skew = 1;
+    WorkerScheduler scheduler = WorkerScheduler::ThreadPool;
+    std::vector<PriorityLane> lanes;
+    uint64_t credit_window = 0;
+    size_t batch_size = 0;
     std::vector<std::string> topics = {"topic0", "topic1", "topic2", "topic3"};
     
     for (int i = 1; i < argc; ++i) {
@@ -91,13 +103,79 @@ int main(int argc, char* argv[]) {
         else if (arg == "--no-work") {
             simulate_work = false;
         }
+        else if (arg == "--skew") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for --skew" << std::endl;
+                return 1;
+            }
+            skew = std::max(1, std::atoi(argv[i + 1]));
+            ++i;
+        }
+        else if (arg == "--credit-window") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for --credit-window" << std::endl;
+                return 1;
+            }
+            credit_window = std::strtoull(argv[i + 1], nullptr, 10);
+            ++i;
+        }
+        else if (arg == "--batch") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for --batch" << std::endl;
+                return 1;
+            }
+            batch_size = std::strtoull(argv[i + 1], nullptr, 10);
+            ++i;
+        }
+        else if (arg == "--lane") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for --lane" << std::endl;
+                return 1;
+            }
+            PriorityLane lane;
+            if (!parse_lane_spec(argv[i + 1], lane.topic_prefixes, lane.sub_connect_addr)) {
+                std::cerr << "Invalid --lane (expected prefix[,prefix...]@address): " << argv[i + 1] << std::endl;
+                return 1;
+            }
+            lanes.push_back(lane);
+            ++i;
+        }
+        else if (arg == "--scheduler") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for --scheduler" << std::endl;
+                return 1;
+            }
+            std::string name = argv[i + 1];
+            if (name == "pool") {
+                scheduler = WorkerScheduler::ThreadPool;
+            } else if (name == "steal") {
+                scheduler = WorkerScheduler::WorkStealing;
+            } else {
+                std::cerr << "Unknown scheduler: " << name << " (expected pool or steal)" << std::endl;
+                return 1;
+            }
+            ++i;
+        }
     }
     
     std::cout << "Starting subscriber with worker pool:" << std::endl;
     std::cout << "  Subscriber address: " << sub_addr << std::endl;
     std::cout << "  Worker threads: " << num_workers << std::endl;
     std::cout << "  HWM: " << hwm << std::endl;
+    std::cout << "  Scheduler: " << (scheduler == WorkerScheduler::WorkStealing ? "steal" : "pool") << std::endl;
     std::cout << "  Simulate work: " << (simulate_work ? "yes" : "no") << std::endl;
+    if (credit_window > 0) {
+        std::cout << "  Credit window: " << credit_window << std::endl;
+    }
+    if (batch_size > 0) {
+        std::cout << "  Batch size: " << batch_size << std::endl;
+    }
+    if (skew > 1 && !topics.empty()) {
+        std::cout << "  Skew: " << skew << "x on " << topics.front() << std::endl;
+    }
+    for (size_t lane = 0; lane < lanes.size(); ++lane) {
+        std::cout << "  Priority lane " << lane << ": " << lanes[lane].sub_connect_addr << std::endl;
+    }
     std::cout << "  Topics: ";
     for (const auto& topic : topics) {
         std::cout << topic << " ";
@@ -106,21 +184,44 @@ int main(int argc, char* argv[]) {
     
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    // kill -USR1 <pid> dumps the flight recorder (see README)
+    FlightRecorder::install_signal_handler(SIGUSR1);
     
     BusConfig config;
     config.sub_connect_addr = sub_addr;
     config.worker_threads = num_workers;
+    config.scheduler = scheduler;
+    config.priority_lanes = lanes;
+    if (credit_window > 0) {
+        // any mode enables granting; throttle vs reject is the publisher's choice
+        config.flow_control = FlowControlMode::Throttle;
+        config.credit_window = credit_window;
+    }
+    if (batch_size > 0) {
+        config.batch_max_messages = batch_size;
+    }
     config.hwm = hwm;
     config.metrics_period = std::chrono::milliseconds(1000);
     
-    MessageHandler handler = [simulate_work](const Message& msg) {
+    // the first topic costs `skew` times more to model skewed handler costs
+    const std::string heavy_topic = topics.empty() ? std::string() : topics.front();
+    MessageHandler handler = [simulate_work, skew, heavy_topic](const Message& msg) {
         if (!simulate_work) {
             return;
         }
-        simulate_handler_work();
+        simulate_handler_work(msg.topic == heavy_topic ? skew : 1);
+    };
+    BatchHandler batch_handler = [simulate_work, skew, heavy_topic](std::span<const MessageView> batch) {
+        if (!simulate_work) {
+            return;
+        }
+        for (const auto& msg : batch) {
+            simulate_handler_work(msg.topic == heavy_topic ? skew : 1);
+        }
     };
 
-    SubscriberBus bus(config, topics, handler);
+    SubscriberBus bus = batch_size > 0 ? SubscriberBus(config, topics, batch_handler)
+                                       : SubscriberBus(config, topics, handler);
     bus.start();
     
     std::cout << "Subscriber started. Waiting for messages..." << std::endl;
@@ -140,6 +241,7 @@ int main(int argc, char* argv[]) {
     
     auto final_stats = bus.get_metrics();
     std::cout << "FINAL METRICS: " << metrics_utils::format_stats(final_stats) << std::endl;
+    std::cout << "FINAL STAGES: " << metrics_utils::format_stage_stats(final_stats) << std::endl;
     
     std::cout << "Subscriber stopped" << std::endl;
     
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "types.hpp"
+#include "wire.hpp"
+#include "publisher.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace messenger {
+
+/**
+ * Schema types carried by Channel<T>: fixed layout, copied with memcpy and
+ * read in place on receive, so no encoding or parsing on either side.
+ */
+template <typename T>
+concept ChannelPayload = std::is_trivially_copyable_v<T>
+                      && std::is_standard_layout_v<T>
+                      && alignof(T) <= 8;
+
+// Specialize to bump the version whenever the layout of T changes
+template <typename T>
+struct ChannelSchema {
+    static constexpr uint32_t version = 0;
+};
+
+namespace channel_detail {
+
+constexpr uint64_t fnv1a(std::string_view text, uint64_t hash = 14695981039346656037ull) {
+    for (char c : text) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+constexpr uint64_t mix(uint64_t hash, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Compiler-generated signature naming T; stable for a given compiler
+template <typename T>
+constexpr std::string_view type_signature() {
+#if defined(_MSC_VER)
+    return __FUNCSIG__;
+#else
+    return __PRETTY_FUNCTION__;
+#endif
+}
+
+} // namespace channel_detail
+
+/**
+ * Channel<T> is a typed layer over PublisherBus/SubscriberBus.
+ *
+ * A typed payload is a ChannelHeader followed by the raw bytes of T. The
+ * header carries a compile-time tag derived from T's name, size, alignment
+ * and ChannelSchema<T>::version; receivers drop payloads whose tag or size
+ * does not match, so mismatched schemas never reach a typed handler.
+ */
+template <ChannelPayload T>
+class Channel {
+public:
+    static constexpr uint64_t type_tag = channel_detail::mix(
+        channel_detail::mix(
+            channel_detail::mix(channel_detail::fnv1a(channel_detail::type_signature<T>()), sizeof(T)),
+            alignof(T)),
+        ChannelSchema<T>::version);
+
+    static constexpr size_t payload_size = sizeof(ChannelHeader) + sizeof(T);
+
+    using Handler = std::function<void(const Message& message, const T& value)>;
+
+    // Storage for view() when the payload cannot be read in place
+    struct Scratch {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    explicit Channel(std::string topic)
+        : topic_(std::move(topic)) {
+    }
+
+    const std::string& topic() const { return topic_; }
+
+    // Single memcpy of `value` straight into the outgoing frame
+    bool publish(Producer& producer, const T& value) const {
+        return producer.produce_in_place(topic_, payload_size, [&value](void* data) {
+            ChannelHeader header;
+            header.type_tag = type_tag;
+            header.size = static_cast<uint32_t>(sizeof(T));
+            std::memcpy(data, &header, sizeof(header));
+            std::memcpy(static_cast<char*>(data) + sizeof(header), &value, sizeof(T));
+        });
+    }
+
+    // Returns a pointer into the message payload, or nullptr if the payload is
+    // not a T. Falls back to copying into `scratch` if the payload is misaligned
+    static const T* view(const Message& message, Scratch& scratch) {
+        const std::string& payload = message.payload;
+        if (payload.size() != payload_size) {
+            return nullptr;
+        }
+
+        ChannelHeader header;
+        std::memcpy(&header, payload.data(), sizeof(header));
+        if (header.type_tag != type_tag || header.size != sizeof(T)) {
+            return nullptr;
+        }
+
+        const char* data = payload.data() + sizeof(ChannelHeader);
+        if (reinterpret_cast<uintptr_t>(data) % alignof(T) != 0) {
+            std::memcpy(scratch.bytes, data, sizeof(T));
+            return reinterpret_cast<const T*>(scratch.bytes);
+        }
+        return reinterpret_cast<const T*>(data);
+    }
+
+    // Adapts a typed handler to SubscriberBus; mismatched payloads are counted in `rejected`
+    static MessageHandler handler(Handler typed, std::atomic<uint64_t>* rejected = nullptr) {
+        return [typed = std::move(typed), rejected](const Message& message) {
+            Scratch scratch;
+            const T* value = view(message, scratch);
+            if (value == nullptr) {
+                if (rejected != nullptr) {
+                    rejected->fetch_add(1, std::memory_order_relaxed);
+                }
+                return;
+            }
+            typed(message, *value);
+        };
+    }
+
+private:
+    std::string topic_;
+};
+
+} // namespace messenger
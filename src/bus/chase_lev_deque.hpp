@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace messenger {
+
+/**
+ * Growable Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+ * Work-Stealing for Weak Memory Models", PPoPP 2013).
+ *
+ * Used in push/steal mode: a single producer (the subscriber I/O thread)
+ * pushes at the bottom, and every consumer - the owning worker as well as
+ * thieves - takes from the top. That keeps per-deque FIFO order, so messages
+ * routed to the same worker are handled in arrival order unless stolen.
+ *
+ * Buffers replaced by growth stay allocated because a thief may still be
+ * reading one; the owner frees them with reclaim() once no steal() can be
+ * in progress.
+ */
+template <typename T>
+class ChaseLevDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "ChaseLevDeque stores items in atomics");
+
+public:
+    explicit ChaseLevDeque(size_t capacity = 1024) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        auto buffer = std::make_unique<Buffer>(rounded);
+        buffer_.store(buffer.get(), std::memory_order_relaxed);
+        buffers_.push_back(std::move(buffer));
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // Producer thread only
+    void push(T item) {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(buffer->mask)) {
+            buffer = grow(buffer, t, b);
+        }
+        buffer->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Any thread; empty result on an empty deque or a lost race
+    std::optional<T> steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return std::nullopt;
+        }
+
+        Buffer* buffer = buffer_.load(std::memory_order_acquire);
+        T item = buffer->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+        return item;
+    }
+
+    bool empty() const {
+        const int64_t t = top_.load(std::memory_order_acquire);
+        const int64_t b = bottom_.load(std::memory_order_acquire);
+        return t >= b;
+    }
+
+    // Producer thread only: true if grow() left older buffers behind
+    bool has_retired() const { return buffers_.size() > 1; }
+
+    // Producer thread only: frees every buffer but the current one. The caller
+    // guarantees no steal() is running or can still hold an older buffer
+    void reclaim() {
+        Buffer* current = buffer_.load(std::memory_order_relaxed);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                      [current](const auto& buffer) { return buffer.get() != current; }),
+                       buffers_.end());
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(size_t capacity)
+            : mask(capacity - 1)
+            , slots(new std::atomic<T>[capacity]) {
+        }
+
+        T get(int64_t index) const {
+            return slots[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, T item) {
+            slots[static_cast<size_t>(index) & mask].store(item, std::memory_order_relaxed);
+        }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Buffer* grow(Buffer* old_buffer, int64_t t, int64_t b) {
+        auto buffer = std::make_unique<Buffer>((old_buffer->mask + 1) * 2);
+        for (int64_t i = t; i < b; ++i) {
+            buffer->put(i, old_buffer->get(i));
+        }
+        Buffer* raw = buffer.get();
+        buffer_.store(raw, std::memory_order_release);
+        // thieves may still be reading older buffers; kept until reclaim()
+        buffers_.push_back(std::move(buffer));
+        return raw;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Buffer*> buffer_{nullptr};
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+} // namespace messenger
@@ -0,0 +1,31 @@
+#include "executor.hpp"
+#include "work_stealing_executor.hpp"
+#include <boost/asio/post.hpp>
+
+namespace messenger {
+
+ThreadPoolExecutor::ThreadPoolExecutor(size_t workers)
+    : pool_(workers) {
+}
+
+void ThreadPoolExecutor::post(Task task, size_t) {
+    boost::asio::post(pool_, std::move(task));
+}
+
+void ThreadPoolExecutor::join() {
+    pool_.join();
+}
+
+std::unique_ptr<Executor> make_executor(const BusConfig& config) {
+    const size_t workers = config.worker_threads > 0 ? static_cast<size_t>(config.worker_threads) : 1;
+    
+    switch (config.scheduler) {
+        case WorkerScheduler::WorkStealing:
+            return std::make_unique<WorkStealingExecutor>(workers);
+        case WorkerScheduler::ThreadPool:
+        default:
+            return std::make_unique<ThreadPoolExecutor>(workers);
+    }
+}
+
+} // namespace messenger
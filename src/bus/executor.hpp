@@ -0,0 +1,46 @@
+#pragma once
+
+#include "types.hpp"
+#include <boost/asio/thread_pool.hpp>
+#include <functional>
+#include <memory>
+
+namespace messenger {
+
+/**
+ * Runs message handling work for SubscriberBus.
+ *
+ * post() is only called from the subscriber I/O thread. `affinity` is a
+ * stable hint (the topic hash) that executors may use to keep related work
+ * on the same worker; it carries no ordering guarantee.
+ */
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+    virtual ~Executor() = default;
+
+    virtual void post(Task task, size_t affinity) = 0;
+
+    // Runs every posted task to completion and stops the workers
+    virtual void join() = 0;
+};
+
+/**
+ * Shared-queue executor backed by boost::asio::thread_pool
+ */
+class ThreadPoolExecutor : public Executor {
+public:
+    explicit ThreadPoolExecutor(size_t workers);
+
+    void post(Task task, size_t affinity) override;
+
+    void join() override;
+
+private:
+    boost::asio::thread_pool pool_;
+};
+
+std::unique_ptr<Executor> make_executor(const BusConfig& config);
+
+} // namespace messenger
@@ -0,0 +1,190 @@
+#include "flight_recorder.hpp"
+#include <algorithm>
+#include <csignal>
+#include <fstream>
+#include <new>
+#include <unistd.h>
+
+namespace messenger {
+
+namespace {
+std::atomic<uint64_t> g_next_recorder_token{1};
+
+size_t round_up_pow2(size_t value) {
+    if (value == 0) {
+        return 0;
+    }
+    size_t capacity = 1;
+    while (capacity < value) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+void on_dump_signal(int) {
+    // each recorder's dump thread notices the request and does the file I/O
+    FlightRecorder::request_dump();
+}
+}
+
+std::atomic<uint64_t> FlightRecorder::dump_requests_{0};
+thread_local FlightRecorder::ThreadRings FlightRecorder::t_rings;
+
+FlightRecorder::Ring::Ring(size_t capacity)
+    : mask(capacity - 1)
+    , slots(new Slot[capacity]) {
+    for (size_t i = 0; i < capacity; ++i) {
+        for (auto& word : slots[i].words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void FlightRecorder::Ring::snapshot(std::vector<FlightEvent>& out) const {
+    const uint64_t capacity = mask + 1;
+    const uint64_t end = committed.load(std::memory_order_acquire);
+    const uint64_t begin = end > capacity ? end - capacity : 0;
+    
+    std::vector<FlightEvent> copied;
+    copied.reserve(end - begin);
+    for (uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = slots[index & mask];
+        uint64_t words[4];
+        for (size_t i = 0; i < 4; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        FlightEvent event;
+        std::memcpy(&event, words, sizeof(event));
+        copied.push_back(event);
+    }
+    
+    // slots the writer claimed while we copied may be torn; drop them
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t claimed_now = claimed.load(std::memory_order_relaxed);
+    const uint64_t valid_begin = std::max(begin, claimed_now > capacity ? claimed_now - capacity : 0);
+    if (valid_begin < end) {
+        out.insert(out.end(), copied.begin() + (valid_begin - begin), copied.end());
+    }
+}
+
+FlightRecorder::FlightRecorder(size_t events_per_thread, std::string dump_prefix)
+    : capacity_(round_up_pow2(events_per_thread))
+    , dump_prefix_(std::move(dump_prefix))
+    , token_(g_next_recorder_token.fetch_add(1, std::memory_order_relaxed))
+    , registry_(std::make_shared<Registry>())
+    , seen_dump_requests_(dump_requests_.load()) {
+}
+
+FlightRecorder::~FlightRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(dump_mutex_);
+        stopping_ = true;
+    }
+    dump_cv_.notify_all();
+    if (dump_thread_.joinable()) {
+        dump_thread_.join();
+    }
+}
+
+FlightRecorder::ThreadRings::~ThreadRings() {
+    for (auto& [token, entry] : entries) {
+        if (auto registry = entry.registry.lock()) {
+            std::lock_guard<std::mutex> lock(registry->mutex);
+            registry->free_rings.push_back(entry.ring);
+        }
+    }
+}
+
+FlightRecorder::Ring* FlightRecorder::register_thread() noexcept {
+    // recording is best effort: out of memory drops the event instead of
+    // throwing out of produce() or a handler
+    try {
+        ThreadRings::Entry& entry = t_rings.entries[token_];
+        if (entry.ring == nullptr) {
+            std::lock_guard<std::mutex> lock(registry_->mutex);
+            if (registry_->free_rings.empty()) {
+                registry_->free_rings.reserve(registry_->rings.size() + 1);
+                auto ring = std::make_unique<Ring>(capacity_);
+                registry_->rings.push_back(std::move(ring));
+                entry.ring = registry_->rings.back().get();
+            } else {
+                entry.ring = registry_->free_rings.back();
+                registry_->free_rings.pop_back();
+            }
+            entry.ring->thread = registry_->next_thread++;
+            entry.registry = registry_;
+        }
+        
+        t_last_ring.recorder_token = token_;
+        t_last_ring.ring = entry.ring;
+        return entry.ring;
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+bool FlightRecorder::dump(const std::string& path, std::string_view name) const {
+    std::vector<FlightEvent> events;
+    size_t thread_count = 0;
+    {
+        std::lock_guard<std::mutex> lock(registry_->mutex);
+        thread_count = registry_->next_thread;
+        for (const auto& ring : registry_->rings) {
+            ring->snapshot(events);
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const FlightEvent& a, const FlightEvent& b) {
+        return a.ticks < b.ticks;
+    });
+    
+    FlightDumpHeader header;
+    std::memcpy(header.magic, kFlightDumpMagic, sizeof(header.magic));
+    header.ns_per_tick = TscClock::ns_per_tick();
+    header.event_count = events.size();
+    header.pid = static_cast<uint32_t>(::getpid());
+    header.thread_count = static_cast<uint32_t>(thread_count);
+    name.copy(header.name, sizeof(header.name) - 1);
+    
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(events.data()),
+              static_cast<std::streamsize>(events.size() * sizeof(FlightEvent)));
+    return static_cast<bool>(out);
+}
+
+void FlightRecorder::watch_dump_requests(std::string name) {
+    if (capacity_ == 0 || dump_thread_.joinable()) {
+        return;
+    }
+    dump_thread_ = std::thread(&FlightRecorder::dump_thread_loop, this, std::move(name));
+}
+
+void FlightRecorder::dump_thread_loop(std::string name) {
+    std::unique_lock<std::mutex> lock(dump_mutex_);
+    while (true) {
+        const bool stopping = dump_cv_.wait_for(lock, kDumpPollInterval, [this]() { return stopping_; });
+        
+        // checked once more on shutdown, so a request just before stop() is still written
+        const uint64_t requests = dump_requests_.load(std::memory_order_relaxed);
+        if (requests != seen_dump_requests_) {
+            seen_dump_requests_ = requests;
+            const std::string path = dump_prefix_ + "." + name + "." + std::to_string(::getpid())
+                + "." + std::to_string(requests) + ".bin";
+            lock.unlock();
+            dump(path, name);
+            lock.lock();
+        }
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void FlightRecorder::install_signal_handler(int signum) {
+    std::signal(signum, on_dump_signal);
+}
+
+} // namespace messenger
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "tsc_clock.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace messenger {
+
+enum class FlightEventType : uint16_t {
+    Produce = 1,   // producer thread handed the message to ingress
+    Forward,       // publisher I/O thread sent it on XPUB
+    Receive,       // subscriber I/O thread read it from SUB
+    Dispatch,      // subscriber I/O thread posted it (or its batch) to the executor
+    HandlerStart,
+    HandlerEnd,
+    Drop,          // message lost; aux is a DropReason
+};
+
+enum class DropReason : uint64_t {
+    Closed = 1,    // bus stopped or producers closed
+    FlowControl,   // out of subscriber credit
+    SendFailed,    // ingress socket error
+    Incomplete,    // subscriber: fragmented message expired before all chunks arrived
+    Oversized,     // subscriber: fragmented message above reassembly_max_size
+};
+
+/**
+ * One recorded event, 32 bytes in memory and on disk.
+ *
+ * message_id is the message's WireHeader::produce_ticks, which both sides
+ * see, so events of one message can be joined across publisher and subscriber
+ * dumps taken on the same host. It is 0 for messages sent with
+ * BusConfig::stage_timestamps off and for drops before a message was
+ * stamped (closed producers, flow control).
+ */
+struct FlightEvent {
+    uint64_t ticks = 0;       // TscClock::now()
+    uint64_t message_id = 0;
+    uint64_t aux = 0;         // payload size, batch size or DropReason
+    uint32_t thread = 0;      // per-recorder thread index
+    uint16_t type = 0;        // FlightEventType
+    uint16_t lane = 0;
+};
+
+static_assert(sizeof(FlightEvent) == 32 && std::is_trivially_copyable_v<FlightEvent>);
+
+constexpr char kFlightDumpMagic[8] = {'B', 'U', 'S', 'F', 'L', 'I', 'T', 'E'};
+constexpr uint32_t kFlightDumpVersion = 1;
+
+// Dump file layout: FlightDumpHeader, then event_count FlightEvents sorted by ticks
+struct FlightDumpHeader {
+    char magic[8] = {};
+    uint32_t version = kFlightDumpVersion;
+    uint32_t event_size = sizeof(FlightEvent);
+    double ns_per_tick = 1.0;
+    uint64_t event_count = 0;
+    uint32_t pid = 0;
+    uint32_t thread_count = 0;
+    char name[48] = {};       // "publisher" or the subscriber id, truncated
+};
+
+static_assert(std::is_trivially_copyable_v<FlightDumpHeader>);
+
+/**
+ * Always-on flight recorder: every thread that records gets its own ring of
+ * the most recent events, so recording is a few relaxed stores with no
+ * locks or shared cache lines.
+ *
+ * dump() snapshots all rings while they are being written; events that were
+ * overwritten during the copy are discarded rather than torn. Dumps can also
+ * be requested by a signal (install_signal_handler()); a watcher thread per
+ * recorder notices the request within kDumpPollInterval and writes
+ * "<BusConfig::flight_recorder_path>.<name>.<pid>.<n>.bin". It depends on no
+ * bus thread, so a wedged I/O thread can still be dumped, and sorting and
+ * file I/O never stall the bus.
+ *
+ * A thread's ring is handed to the next new thread once it exits, keeping
+ * memory bounded under thread churn; its old events stay visible until
+ * overwritten, under the old thread index.
+ */
+class FlightRecorder {
+public:
+    // events_per_thread is rounded up to a power of two; 0 disables recording
+    FlightRecorder(size_t events_per_thread, std::string dump_prefix);
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    bool enabled() const { return capacity_ != 0; }
+
+    void record(FlightEventType type, uint64_t message_id, uint64_t aux = 0, uint16_t lane = 0) noexcept {
+        if (capacity_ == 0) {
+            return;
+        }
+        if (Ring* ring = local_ring()) {
+            ring->write(type, message_id, aux, lane);
+        }
+    }
+
+    // Writes every thread's buffered events, oldest first
+    bool dump(const std::string& path, std::string_view name) const;
+
+    // Starts the thread that writes a dump under `name` for every signal
+    // request; called once by the owning bus. No-op when recording is disabled
+    void watch_dump_requests(std::string name);
+    
+    static constexpr std::chrono::milliseconds kDumpPollInterval{50};
+
+    // Makes `signum` (e.g. SIGUSR1) request a dump from every recorder in the process
+    static void install_signal_handler(int signum);
+    
+    // Same as the signal; async-signal-safe
+    static void request_dump() noexcept { dump_requests_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> words[4];
+    };
+
+    // Single writer (the owning thread); dump() reads it concurrently
+    struct Ring {
+        explicit Ring(size_t capacity);
+
+        void write(FlightEventType type, uint64_t message_id, uint64_t aux, uint16_t lane) noexcept {
+            FlightEvent event;
+            event.ticks = TscClock::now();
+            event.message_id = message_id;
+            event.aux = aux;
+            event.thread = thread;
+            event.type = static_cast<uint16_t>(type);
+            event.lane = lane;
+            uint64_t words[4];
+            std::memcpy(words, &event, sizeof(event));
+
+            // seqlock-style: announce the slot before overwriting it, so a
+            // reader that saw any new word also sees `claimed` moved past it
+            const uint64_t index = committed.load(std::memory_order_relaxed);
+            claimed.store(index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            Slot& slot = slots[index & mask];
+            for (size_t i = 0; i < 4; ++i) {
+                slot.words[i].store(words[i], std::memory_order_relaxed);
+            }
+            committed.store(index + 1, std::memory_order_release);
+        }
+
+        void snapshot(std::vector<FlightEvent>& out) const;
+
+        uint32_t thread = 0;  // set under Registry::mutex whenever a thread takes the ring
+        const uint64_t mask;
+        std::unique_ptr<Slot[]> slots;
+        alignas(64) std::atomic<uint64_t> claimed{0};
+        std::atomic<uint64_t> committed{0};
+    };
+
+    // Shared with the threads' ThreadRings, which outlive the recorder
+    struct Registry {
+        std::mutex mutex;
+        // rings outlive their threads so a dump still shows what exited threads did
+        std::vector<std::unique_ptr<Ring>> rings;
+        std::vector<Ring*> free_rings;  // capacity kept >= rings.size(), so returning never allocates
+        uint32_t next_thread = 0;
+    };
+
+    // zero-initialized as a thread_local; token 0 is never handed out
+    struct RingCacheEntry {
+        uint64_t recorder_token;
+        Ring* ring;
+    };
+
+    // This thread's ring in each recorder; on thread exit, rings of recorders
+    // that still exist go back to their free list
+    struct ThreadRings {
+        struct Entry {
+            std::weak_ptr<Registry> registry;
+            Ring* ring = nullptr;
+        };
+        std::unordered_map<uint64_t, Entry> entries;  // by recorder token
+
+        ~ThreadRings();
+    };
+
+    // the last recorder used by this thread is checked before the map lookup;
+    // tokens are never reused, so entries of destroyed recorders never match.
+    // t_rings is defined in flight_recorder.cpp: its destructor lives there, and
+    // tools that only read dumps include this header without linking it
+    static inline thread_local RingCacheEntry t_last_ring;
+    static thread_local ThreadRings t_rings;
+
+    Ring* local_ring() noexcept {
+        if (t_last_ring.recorder_token == token_) {
+            return t_last_ring.ring;
+        }
+        return register_thread();
+    }
+
+    // Takes a free ring or allocates one; nullptr (the event is not recorded)
+    // if that allocation failed
+    Ring* register_thread() noexcept;
+
+    void dump_thread_loop(std::string name);
+
+    const size_t capacity_;
+    const std::string dump_prefix_;
+    const uint64_t token_;
+    const std::shared_ptr<Registry> registry_;
+
+    static std::atomic<uint64_t> dump_requests_;
+    
+    // signal-requested dumps; the signal handler cannot notify, so the thread
+    // polls dump_requests_ and dump_cv_ only wakes it for shutdown
+    std::mutex dump_mutex_;
+    std::condition_variable dump_cv_;
+    bool stopping_ = false;
+    uint64_t seen_dump_requests_ = 0;  // dump thread only
+    std::thread dump_thread_;
+};
+
+} // namespace messenger
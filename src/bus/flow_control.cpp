@@ -0,0 +1,180 @@
+#include "flow_control.hpp"
+#include "tsc_clock.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace messenger {
+
+namespace {
+constexpr auto kExpiryScanInterval = std::chrono::milliseconds(5);
+}
+
+FlowControl::FlowControl(const BusConfig& config)
+    : mode_(config.flow_control)
+    , timeout_(config.flow_control_timeout)
+    , expiry_(config.credit_expiry)
+    , period_(config.credit_period)
+    , required_(config.credit_required_subscribers.begin(), config.credit_required_subscribers.end())
+    , last_expiry_ticks_(TscClock::now()) {
+}
+
+void FlowControl::on_grant(const std::string& subscriber_id, const CreditGrant& grant, std::vector<std::string> prefixes) {
+    if (!required_.empty() && required_.count(subscriber_id) == 0) {
+        return;
+    }
+    
+    const uint64_t now = TscClock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = subscribers_.try_emplace(subscriber_id);
+    Entry& entry = it->second;
+    
+    if (inserted || entry.epoch != grant.epoch) {
+        // new or restarted subscriber: sync our count with what it has seen
+        entry.epoch = grant.epoch;
+        entry.sent = grant.received;
+        entry.lagging_since_ticks = 0;
+    } else {
+        // never count fewer than it reports receiving (messages in flight at registration)
+        entry.sent = std::max(entry.sent, grant.received);
+        
+        // the subscriber drains its SUB sockets eagerly, so a full window that
+        // is still missing a grant period later was dropped on the way
+        const uint64_t window = grant.granted - std::min(grant.granted, grant.completed);
+        if (entry.sent - grant.received < std::max<uint64_t>(window, 1)) {
+            entry.lagging_since_ticks = 0;
+        } else if (entry.lagging_since_ticks == 0) {
+            entry.lagging_since_ticks = now;
+        } else if (TscClock::elapsed(entry.lagging_since_ticks, now) >= period_) {
+            entry.lost += entry.sent - grant.received;
+            entry.sent = grant.received;
+            entry.lagging_since_ticks = 0;
+        }
+    }
+    
+    entry.granted = grant.granted;
+    entry.prefixes = std::move(prefixes);
+    entry.last_grant_ticks = now;
+    entry.required = required_.count(subscriber_id) != 0;
+    update_blocked_locked(entry);
+}
+
+void FlowControl::on_forward(std::string_view topic) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [subscriber_id, entry] : subscribers_) {
+        if (matches(entry, topic)) {
+            ++entry.sent;
+            update_blocked_locked(entry);
+        }
+    }
+}
+
+void FlowControl::expire() {
+    const uint64_t now = TscClock::now();
+    if (TscClock::elapsed(last_expiry_ticks_, now) < kExpiryScanInterval) {
+        return;
+    }
+    last_expiry_ticks_ = now;
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = subscribers_.begin(); it != subscribers_.end();) {
+        Entry& entry = it->second;
+        if (!entry.required && TscClock::elapsed(entry.last_grant_ticks, now) > expiry_) {
+            if (entry.blocked) {
+                --blocked_count_;
+            }
+            it = subscribers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    any_blocked_.store(blocked_count_ > 0, std::memory_order_release);
+}
+
+bool FlowControl::admit(std::string_view topic) {
+    if (!any_blocked_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!topic_blocked_locked(topic)) {
+            return true;
+        }
+    }
+    
+    if (mode_ == FlowControlMode::Reject) {
+        rejected_produces_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    throttled_produces_.fetch_add(1, std::memory_order_relaxed);
+    const auto deadline = std::chrono::steady_clock::now() + timeout_;
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+        if (!any_blocked_.load(std::memory_order_acquire)) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!topic_blocked_locked(topic)) {
+            return true;
+        }
+    }
+    
+    rejected_produces_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+FlowControl::State FlowControl::state() {
+    State state;
+    state.throttled_produces = throttled_produces_.load(std::memory_order_relaxed);
+    state.rejected_produces = rejected_produces_.load(std::memory_order_relaxed);
+    
+    const uint64_t now = TscClock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    state.any_blocked = blocked_count_ > 0;
+    for (const auto& [subscriber_id, entry] : subscribers_) {
+        SubscriberState subscriber;
+        subscriber.subscriber_id = subscriber_id;
+        subscriber.granted = entry.granted;
+        subscriber.sent = entry.sent;
+        subscriber.lost = entry.lost;
+        subscriber.credit = static_cast<int64_t>(entry.granted) - static_cast<int64_t>(entry.sent);
+        subscriber.required = entry.required;
+        subscriber.blocked = entry.blocked;
+        subscriber.since_last_grant = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::max(TscClock::elapsed(entry.last_grant_ticks, now), std::chrono::nanoseconds(0)));
+        state.subscribers.push_back(std::move(subscriber));
+    }
+    return state;
+}
+
+bool FlowControl::matches(const Entry& entry, std::string_view topic) {
+    for (const auto& prefix : entry.prefixes) {
+        if (topic.substr(0, prefix.size()) == prefix) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FlowControl::topic_blocked_locked(std::string_view topic) const {
+    for (const auto& [subscriber_id, entry] : subscribers_) {
+        if (entry.blocked && matches(entry, topic)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FlowControl::update_blocked_locked(Entry& entry) {
+    const bool blocked = entry.sent >= entry.granted;
+    if (blocked == entry.blocked) {
+        return;
+    }
+    
+    entry.blocked = blocked;
+    blocked ? ++blocked_count_ : --blocked_count_;
+    any_blocked_.store(blocked_count_ > 0, std::memory_order_release);
+}
+
+} // namespace messenger
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "types.hpp"
+#include "wire.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace messenger {
+
+/**
+ * Publisher-side credit accounting for BusConfig::flow_control.
+ *
+ * The publisher I/O thread feeds it credit grants and every forwarded topic;
+ * producer threads call admit() before sending. A topic is blocked while any
+ * gating subscriber whose prefixes match it has sent as many messages as it
+ * granted. Credit is checked at produce() time and charged at forward time,
+ * so the ingress backlog can overshoot a grant slightly; credit_window must
+ * leave that headroom below the HWMs.
+ *
+ * Messages dropped after forwarding (HWM, reconnect) never show up in the
+ * subscriber's `received` count. Once the charged count stays a full window
+ * ahead of it for a grant period, the gap is written off as lost and the
+ * charge resyncs to `received`, so drops cannot starve a topic for good.
+ */
+class FlowControl {
+public:
+    struct SubscriberState {
+        std::string subscriber_id;
+        uint64_t granted = 0;
+        uint64_t sent = 0;
+        uint64_t lost = 0;   // charged but never received, written off by resyncs
+        int64_t credit = 0;
+        bool required = false;
+        bool blocked = false;
+        std::chrono::milliseconds since_last_grant{0};
+    };
+
+    struct State {
+        bool any_blocked = false;
+        uint64_t throttled_produces = 0;  // produce() calls that had to wait for credit
+        uint64_t rejected_produces = 0;   // produce() calls refused for lack of credit
+        std::vector<SubscriberState> subscribers;
+    };
+
+    explicit FlowControl(const BusConfig& config);
+
+    // I/O thread: records a grant from the flow-control channel
+    void on_grant(const std::string& subscriber_id, const CreditGrant& grant, std::vector<std::string> prefixes);
+
+    // I/O thread: charges a forwarded message to every subscriber it reaches
+    void on_forward(std::string_view topic);
+
+    // I/O thread: drops non-required subscribers that stopped granting;
+    // cheap to call every pass, the table is scanned at most every few ms
+    void expire();
+
+    // Producer threads: false if the topic stays blocked (per FlowControlMode)
+    bool admit(std::string_view topic);
+
+    State state();
+
+private:
+    struct Entry {
+        uint64_t epoch = 0;
+        uint64_t granted = 0;
+        uint64_t sent = 0;
+        uint64_t lost = 0;
+        std::vector<std::string> prefixes;
+        uint64_t last_grant_ticks = 0;
+        uint64_t lagging_since_ticks = 0;  // 0 while sent is within a window of received
+        bool required = false;
+        bool blocked = false;
+    };
+
+    static bool matches(const Entry& entry, std::string_view topic);
+    bool topic_blocked_locked(std::string_view topic) const;
+    void update_blocked_locked(Entry& entry);
+
+    const FlowControlMode mode_;
+    const std::chrono::milliseconds timeout_;
+    const std::chrono::milliseconds expiry_;
+    const std::chrono::milliseconds period_;
+    const std::unordered_set<std::string> required_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> subscribers_;
+    size_t blocked_count_ = 0;
+    uint64_t last_expiry_ticks_ = 0;
+
+    // lets admit() skip the lock entirely while nothing is blocked
+    std::atomic<bool> any_blocked_{false};
+    std::atomic<uint64_t> throttled_produces_{0};
+    std::atomic<uint64_t> rejected_produces_{0};
+};
+
+} // namespace messenger
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "types.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace messenger {
+
+/**
+ * Lane lookup shared by PublisherBus and SubscriberBus. Lanes are indexed in
+ * priority order; the last index is the default lane built from the base
+ * BusConfig addresses.
+ */
+inline size_t lane_count(const BusConfig& config) {
+    return config.priority_lanes.size() + 1;
+}
+
+inline size_t default_lane(const BusConfig& config) {
+    return config.priority_lanes.size();
+}
+
+// First lane with a matching prefix wins, so list more specific prefixes first
+inline size_t lane_for_topic(const BusConfig& config, std::string_view topic) {
+    for (size_t lane = 0; lane < config.priority_lanes.size(); ++lane) {
+        for (const auto& prefix : config.priority_lanes[lane].topic_prefixes) {
+            if (topic.substr(0, prefix.size()) == prefix) {
+                return lane;
+            }
+        }
+    }
+    return default_lane(config);
+}
+
+// True if topics matching the subscription prefix can travel on `lane`.
+// Unlike lane_for_topic(), a prefix may span lanes: "" or "ord" must be
+// subscribed on the "orders" lane too, and on the default lane unless a
+// lane prefix covers the whole subscription
+inline bool lane_carries_subscription(const BusConfig& config, size_t lane, std::string_view subscription) {
+    auto starts_with = [](std::string_view text, std::string_view prefix) {
+        return text.substr(0, prefix.size()) == prefix;
+    };
+    
+    if (lane == default_lane(config)) {
+        for (const auto& priority_lane : config.priority_lanes) {
+            for (const auto& prefix : priority_lane.topic_prefixes) {
+                if (starts_with(subscription, prefix)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    
+    for (const auto& prefix : config.priority_lanes[lane].topic_prefixes) {
+        if (starts_with(subscription, prefix) || starts_with(prefix, subscription)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parses a command-line lane "prefix1,prefix2@address"; the address is the
+// bind address on the publisher side and the connect address on the subscriber side
+inline bool parse_lane_spec(const std::string& spec, std::vector<std::string>& topic_prefixes, std::string& address) {
+    const size_t at = spec.find('@');
+    if (at == std::string::npos || at == 0 || at + 1 >= spec.size()) {
+        return false;
+    }
+    
+    size_t pos = 0;
+    const std::string prefixes = spec.substr(0, at);
+    while (pos <= prefixes.length()) {
+        size_t next_pos = prefixes.find(',', pos);
+        if (next_pos == std::string::npos) {
+            next_pos = prefixes.length();
+        }
+        if (next_pos > pos) {
+            topic_prefixes.push_back(prefixes.substr(pos, next_pos - pos));
+        }
+        pos = next_pos + 1;
+    }
+    
+    address = spec.substr(at + 1);
+    return !topic_prefixes.empty();
+}
+
+inline const std::string& lane_pub_bind_addr(const BusConfig& config, size_t lane) {
+    return lane == default_lane(config) ? config.pub_bind_addr : config.priority_lanes[lane].pub_bind_addr;
+}
+
+inline const std::string& lane_sub_connect_addr(const BusConfig& config, size_t lane) {
+    return lane == default_lane(config) ? config.sub_connect_addr : config.priority_lanes[lane].sub_connect_addr;
+}
+
+inline std::string lane_ingress_addr(const BusConfig& config, size_t lane) {
+    return lane == default_lane(config) ? config.inproc_ingress
+                                        : config.inproc_ingress + ".lane" + std::to_string(lane);
+}
+
+} // namespace messenger
@@ -1,12 +1,25 @@
 #include "metrics.hpp"
+#include "tsc_clock.hpp"
 #include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <iomanip>
 
 namespace messenger {
 
+const char* stage_name(Stage stage) {
+    switch (stage) {
+        case Stage::Ingress: return "ingress";
+        case Stage::Network: return "network";
+        case Stage::WorkerQueue: return "queue";
+        case Stage::Handler: return "handler";
+        default: return "unknown";
+    }
+}
+
 Metrics::Metrics(std::chrono::milliseconds window_size)
     : window_size_(window_size)
+    , stage_slots_(std::make_unique<StageSlot[]>(kStageSampleCapacity))
     , last_rate_calc_(std::chrono::steady_clock::now()) {
 }
 
@@ -21,6 +34,24 @@ void Metrics::record_message_processed() {
     messages_processed_.fetch_add(1);
 }
 
+void Metrics::record_messages_processed(uint64_t count) {
+    messages_processed_.fetch_add(count);
+}
+
+void Metrics::record_stage_latencies(const StageLatencies& latencies) {
+    const uint64_t index = stage_head_.fetch_add(1, std::memory_order_relaxed);
+    StageSlot& slot = stage_slots_[index % kStageSampleCapacity];
+    
+    // sequence 2 * index + 1 marks the slot as being written, + 2 as holding sample `index`
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.ticks.store(TscClock::now(), std::memory_order_relaxed);
+    for (size_t i = 0; i < kStageCount; ++i) {
+        slot.latency_ns[i].store(latencies[i].count(), std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
 Metrics::Stats Metrics::get_stats() {
     Stats stats;
     
@@ -52,6 +83,46 @@ Metrics::Stats Metrics::get_stats() {
         }
     }
     
+    // Copy the ring's settled slots that fall inside the window; a slot whose
+    // sequence changed while it was read was being rewritten and is skipped
+    const uint64_t now_ticks = TscClock::now();
+    std::array<std::vector<double>, kStageCount> stage_sorted;
+    for (size_t slot_index = 0; slot_index < kStageSampleCapacity; ++slot_index) {
+        const StageSlot& slot = stage_slots_[slot_index];
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence == 0 || (sequence & 1) != 0) {
+            continue;
+        }
+        
+        const uint64_t ticks = slot.ticks.load(std::memory_order_relaxed);
+        std::array<int64_t, kStageCount> latency_ns;
+        for (size_t i = 0; i < kStageCount; ++i) {
+            latency_ns[i] = slot.latency_ns[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+        
+        // a slightly-ahead stamp from another core reads negative and stays in the window
+        if (TscClock::elapsed(ticks, now_ticks) > window_size_) {
+            continue;
+        }
+        for (size_t i = 0; i < kStageCount; ++i) {
+            if (latency_ns[i] >= 0) {
+                stage_sorted[i].push_back(static_cast<double>(latency_ns[i]));
+            }
+        }
+    }
+    
+    for (size_t i = 0; i < kStageCount; ++i) {
+        std::sort(stage_sorted[i].begin(), stage_sorted[i].end());
+        
+        stats.stages[i].p50 = calculate_percentile(stage_sorted[i], 50.0);
+        stats.stages[i].p90 = calculate_percentile(stage_sorted[i], 90.0);
+        stats.stages[i].p99 = calculate_percentile(stage_sorted[i], 99.0);
+    }
+    
     stats.messages_processed = current_count;
     
     return stats;
@@ -60,6 +131,9 @@ Metrics::Stats Metrics::get_stats() {
 void Metrics::reset() {
     std::lock_guard<std::mutex> lock(samples_mutex_);
     latency_samples_.clear();
+    for (size_t slot_index = 0; slot_index < kStageSampleCapacity; ++slot_index) {
+        stage_slots_[slot_index].sequence.store(0, std::memory_order_relaxed);
+    }
     messages_processed_.store(0);
     last_rate_calc_ = std::chrono::steady_clock::now();
     last_message_count_ = 0;
@@ -100,6 +174,22 @@ std::string format_stats(const Metrics::Stats& stats) {
     return oss.str();
 }
 
+std::string format_stage_stats(const Metrics::Stats& stats) {
+    std::ostringstream oss;
+    for (size_t i = 0; i < kStageCount; ++i) {
+        const auto& stage = stats.stages[i];
+        if (i > 0) {
+            oss << " ";
+        }
+        oss << stage_name(static_cast<Stage>(i))
+            << "[p50=" << format_duration(std::chrono::nanoseconds(static_cast<int64_t>(stage.p50)))
+            << " p90=" << format_duration(std::chrono::nanoseconds(static_cast<int64_t>(stage.p90)))
+            << " p99=" << format_duration(std::chrono::nanoseconds(static_cast<int64_t>(stage.p99)))
+            << "]";
+    }
+    return oss.str();
+}
+
 std::string format_duration(std::chrono::nanoseconds duration) {
     auto ns = duration.count();
     std::ostringstream oss;
@@ -6,32 +6,67 @@
 #include <atomic>
 #include <mutex>
 #include <string>
+#include <array>
+#include <memory>
+#include <cstdint>
 
 namespace messenger {
 
+/**
+ * Pipeline stages traced with TscClock stamps, in message order
+ */
+enum class Stage : size_t {
+    Ingress,      // produce() -> publisher I/O thread forward
+    Network,      // publisher forward -> subscriber I/O receive
+    WorkerQueue,  // subscriber receive -> worker dequeue
+    Handler,      // worker dequeue -> handler completion
+    Count
+};
+
+constexpr size_t kStageCount = static_cast<size_t>(Stage::Count);
+
+const char* stage_name(Stage stage);
+
 /**
  * Thread-safe metrics collector for latency and throughput statistics
  */
 class Metrics {
 public:
+    struct StageStats {
+        double p50 = 0.0;
+        double p90 = 0.0;
+        double p99 = 0.0;
+    };
+
     struct Stats {
         double p50 = 0.0;
         double p90 = 0.0;
         double p99 = 0.0;
         uint64_t messages_processed = 0;
         double messages_per_second = 0.0;
+        std::array<StageStats, kStageCount> stages{};
     };
 
+    // Negative entries mark stages that were not stamped for this message, or
+    // whose stamps were out of order; they are left out of the percentiles
+    using StageLatencies = std::array<std::chrono::nanoseconds, kStageCount>;
+
     explicit Metrics(std::chrono::milliseconds window_size = std::chrono::milliseconds(1000));
     
     void record_latency(std::chrono::nanoseconds latency);
     
     void record_message_processed();
     
+    void record_messages_processed(uint64_t count);
+    
+    // Lock-free; keeps the most recent kStageSampleCapacity messages
+    void record_stage_latencies(const StageLatencies& latencies);
     
     Stats get_stats();
     
     void reset();
+    
+    static constexpr size_t kStageSampleCapacity = 1 << 16;
 
 private:
     double calculate_percentile(const std::vector<double>& sorted_samples, double percentile);
@@ -46,6 +81,18 @@ private:
     std::deque<LatencySample> latency_samples_;
     std::mutex samples_mutex_;
     
+    // Ring of stage samples written by worker threads without a lock: a writer
+    // claims a slot with one fetch_add and brackets its stores with the slot's
+    // sequence (odd while writing), so get_stats() skips slots mid-write.
+    // Windowed on TscClock ticks, which are cheaper to read than steady_clock
+    struct StageSlot {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> ticks{0};
+        std::array<std::atomic<int64_t>, kStageCount> latency_ns{};
+    };
+    std::unique_ptr<StageSlot[]> stage_slots_;
+    std::atomic<uint64_t> stage_head_{0};
+    
     std::atomic<uint64_t> messages_processed_{0};
     
     std::chrono::steady_clock::time_point last_rate_calc_;
@@ -57,6 +104,7 @@ private:
  */
 namespace metrics_utils {
     std::string format_stats(const Metrics::Stats& stats);
+    std::string format_stage_stats(const Metrics::Stats& stats);
     std::string format_duration(std::chrono::nanoseconds duration);
 }
 
@@ -1,26 +1,234 @@
 #include "publisher.hpp"
+#include "tsc_clock.hpp"
+#include "wire.hpp"
 #include <zmq_addon.hpp>
 #include <iostream>
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <random>
 #include <unordered_map>
 
 namespace messenger {
 
 namespace {
-struct PushSocketCacheEntry {
+struct ProducerCacheEntry {
     uint64_t bus_token = 0;
-    uint64_t owner_id = 0;
-    zmq::socket_t* socket = nullptr;
+    Producer* producer = nullptr;
 };
 
-thread_local std::unordered_map<const PublisherBus*, PushSocketCacheEntry> g_push_socket_cache;
+// the last bus used by this thread is checked before the map lookup
+thread_local const PublisherBus* g_last_producer_bus = nullptr;
+thread_local ProducerCacheEntry g_last_producer;
+thread_local std::unordered_map<const PublisherBus*, ProducerCacheEntry> g_producer_cache;
 std::atomic<uint64_t> g_next_bus_cache_token{1};
+
+// Keeps a fragmented payload alive until ZeroMQ released every chunk
+struct FragmentSource {
+    zmq::message_t payload;
+    std::atomic<uint32_t> refs{1};
+};
+
+void release_fragment_source(void*, void* hint) {
+    auto* source = static_cast<FragmentSource*>(hint);
+    if (source->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete source;
+    }
+}
+
+uint64_t random_stream_base() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+}
+}
+
+Producer::Producer(PublisherBus& bus, Counters& counters)
+    : bus_(&bus)
+    , counters_(&counters) {
+}
+
+Producer::Producer(Producer&& other) noexcept
+    : bus_(other.bus_)
+    , counters_(other.counters_)
+    , push_sockets_(std::move(other.push_sockets_)) {
+    other.bus_ = nullptr;
+    other.counters_ = nullptr;
+}
+
+Producer& Producer::operator=(Producer&& other) noexcept {
+    if (this != &other) {
+        if (counters_ != nullptr) {
+            bus_->retire_producer(*counters_);
+        }
+        bus_ = other.bus_;
+        counters_ = other.counters_;
+        push_sockets_ = std::move(other.push_sockets_);
+        other.bus_ = nullptr;
+        other.counters_ = nullptr;
+    }
+    return *this;
+}
+
+Producer::~Producer() {
+    if (counters_ != nullptr) {
+        bus_->retire_producer(*counters_);
+    }
+}
+
+uint64_t Producer::accepted() const {
+    return counters_ != nullptr ? counters_->accepted.load(std::memory_order_relaxed) : 0;
+}
+
+bool Producer::produce(const Message& msg) {
+    return produce(msg.topic, msg.payload);
+}
+
+bool Producer::produce(std::string_view topic, std::string_view payload) {
+    zmq::message_t payload_msg(payload.size());
+    std::memcpy(payload_msg.data(), payload.data(), payload.size());
+    return send(topic, payload_msg);
+}
+
+bool Producer::send(std::string_view topic, zmq::message_t& payload_msg) {
+    if (bus_ == nullptr) {
+        return false;
+    }
+    
+    auto& recorder = bus_->flight_recorder_;
+    if (!bus_->running_.load() || !bus_->accepting_producers_.load(std::memory_order_acquire)) {
+        recorder.record(FlightEventType::Drop, 0, static_cast<uint64_t>(DropReason::Closed));
+        return false;
+    }
+    
+    if (bus_->flow_control_ && !bus_->flow_control_->admit(topic)) {
+        recorder.record(FlightEventType::Drop, 0, static_cast<uint64_t>(DropReason::FlowControl));
+        return false;
+    }
+    
+    // Dekker handshake with close_producers()/wait_drained(): either we see the
+    // bus closing, or wait_drained() sees this call in flight
+    counters_->in_produce.store(true, std::memory_order_seq_cst);
+    if (!bus_->accepting_producers_.load(std::memory_order_seq_cst)) {
+        counters_->in_produce.store(false, std::memory_order_release);
+        recorder.record(FlightEventType::Drop, 0, static_cast<uint64_t>(DropReason::Closed));
+        return false;
+    }
+    
+    bool sent = false;
+    
+    const size_t lane = lane_for_topic(bus_->config_, topic);
+    const size_t payload_size = payload_msg.size();
+    // also the flight recorder's message id, as subscribers see it in the header
+    const uint64_t produce_ticks = bus_->config_.stage_timestamps ? TscClock::now() : 0;
+    
+    // recorded before the send: the I/O thread may forward it before send() returns
+    recorder.record(FlightEventType::Produce, produce_ticks, payload_size, static_cast<uint16_t>(lane));
+    
+    auto& push_socket = this->push_socket(lane);
+    try {
+        const size_t threshold = bus_->config_.fragment_threshold;
+        if (threshold > 0 && payload_size > threshold) {
+            send_fragments(push_socket, topic, payload_msg, produce_ticks);
+        } else {
+            zmq::message_t topic_msg(topic.data(), topic.size());
+            push_socket.send(topic_msg, zmq::send_flags::sndmore);
+            
+            if (bus_->config_.stage_timestamps) {
+                push_socket.send(payload_msg, zmq::send_flags::sndmore);
+                
+                WireHeader header;
+                header.produce_ticks = produce_ticks;
+                zmq::message_t header_msg(&header, sizeof(header));
+                push_socket.send(header_msg, zmq::send_flags::none);
+            } else {
+                push_socket.send(payload_msg, zmq::send_flags::none);
+            }
+        }
+        
+        sent = true;
+    } catch (const zmq::error_t&) {
+        sent = false;
+    }
+    
+    if (sent) {
+        // single writer, so a plain increment instead of a locked RMW
+        counters_->accepted.store(counters_->accepted.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    } else {
+        recorder.record(FlightEventType::Drop, produce_ticks, static_cast<uint64_t>(DropReason::SendFailed),
+                        static_cast<uint16_t>(lane));
+    }
+    counters_->in_produce.store(false, std::memory_order_release);
+    
+    return sent;
+}
+
+void Producer::send_fragments(zmq::socket_t& socket, std::string_view topic, zmq::message_t& payload,
+                              uint64_t produce_ticks) {
+    const size_t chunk_size = std::max<size_t>(1, bus_->config_.fragment_size);
+    const size_t total_size = payload.size();
+    
+    FragmentHeader fragment;
+    fragment.stream_id = bus_->next_stream_id_.fetch_add(1, std::memory_order_relaxed);
+    fragment.total_size = total_size;
+    fragment.count = static_cast<uint32_t>((total_size + chunk_size - 1) / chunk_size);
+    
+    WireHeader header;
+    header.flags = kWireFlagFragment;
+    header.produce_ticks = produce_ticks;
+    
+    // each chunk frame holds a reference; ours is dropped once all are queued
+    auto* source = new FragmentSource{std::move(payload)};
+    auto* data = static_cast<char*>(source->payload.data());
+    try {
+        for (uint32_t index = 0; index < fragment.count; ++index) {
+            fragment.index = index;
+            fragment.offset = static_cast<uint64_t>(index) * chunk_size;
+            const size_t length = std::min<size_t>(chunk_size, total_size - fragment.offset);
+            
+            zmq::message_t topic_msg(topic.data(), topic.size());
+            source->refs.fetch_add(1, std::memory_order_relaxed);
+            zmq::message_t chunk_msg(data + fragment.offset, length, release_fragment_source, source);
+            zmq::message_t header_msg(&header, sizeof(header));
+            zmq::message_t fragment_msg(&fragment, sizeof(fragment));
+            
+            socket.send(topic_msg, zmq::send_flags::sndmore);
+            socket.send(chunk_msg, zmq::send_flags::sndmore);
+            socket.send(header_msg, zmq::send_flags::sndmore);
+            socket.send(fragment_msg, zmq::send_flags::none);
+        }
+    } catch (...) {
+        release_fragment_source(nullptr, source);
+        throw;
+    }
+    release_fragment_source(nullptr, source);
+}
+
+zmq::socket_t& Producer::push_socket(size_t lane) {
+    if (lane >= push_sockets_.size()) {
+        push_sockets_.resize(lane_count(bus_->config_));
+    }
+    
+    if (!push_sockets_[lane]) {
+        auto socket = std::make_unique<zmq::socket_t>(bus_->context_, zmq::socket_type::push);
+        socket->set(zmq::sockopt::sndhwm, bus_->config_.hwm);
+        socket->connect(lane_ingress_addr(bus_->config_, lane));
+        push_sockets_[lane] = std::move(socket);
+    }
+    return *push_sockets_[lane];
 }
 
 PublisherBus::PublisherBus(const BusConfig& config)
     : config_(config)
+    , flight_recorder_(config.flight_recorder_events, config.flight_recorder_path)
     , cache_token_(g_next_bus_cache_token.fetch_add(1, std::memory_order_relaxed))
-    , context_(config.io_threads) {
+    , context_(config.io_threads)
+    , next_stream_id_(random_stream_base()) {
+    // keep the calibration spin out of the first produce()
+    TscClock::calibrate_now();
+    if (config_.flow_control != FlowControlMode::None) {
+        flow_control_ = std::make_unique<FlowControl>(config_);
+    }
+    flight_recorder_.watch_dump_requests("publisher");
 }
 
 PublisherBus::~PublisherBus() {
@@ -32,24 +240,44 @@ void PublisherBus::start() {
         return;
     }
     
-    pull_socket_.reset(new zmq::socket_t(context_, zmq::socket_type::pull));
-    pub_socket_.reset(new zmq::socket_t(context_, zmq::socket_type::pub));
-    
-    pull_socket_->set(zmq::sockopt::rcvhwm, config_.hwm);
-    pub_socket_->set(zmq::sockopt::sndhwm, config_.hwm);
+    lanes_.clear();
+    lanes_.resize(lane_count(config_));
+    for (size_t lane = 0; lane < lanes_.size(); ++lane) {
+        auto& sockets = lanes_[lane];
+        sockets.pull_socket.reset(new zmq::socket_t(context_, zmq::socket_type::pull));
+        sockets.pub_socket.reset(new zmq::socket_t(context_, zmq::socket_type::xpub));
+        
+        sockets.pull_socket->set(zmq::sockopt::rcvhwm, config_.hwm);
+        sockets.pub_socket->set(zmq::sockopt::sndhwm, config_.hwm);
+        // pass every subscription up so repeated readiness ids are still welcomed
+        sockets.pub_socket->set(zmq::sockopt::xpub_verbose, 1);
+        
+        sockets.pull_socket->bind(lane_ingress_addr(config_, lane));
+        sockets.pub_socket->bind(lane_pub_bind_addr(config_, lane));
+    }
     
-    pull_socket_->bind(config_.inproc_ingress);
-    pub_socket_->bind(config_.pub_bind_addr);
+    if (flow_control_) {
+        credit_socket_.reset(new zmq::socket_t(context_, zmq::socket_type::pull));
+        credit_socket_->set(zmq::sockopt::linger, 0);
+        credit_socket_->bind(config_.credit_bind_addr);
+    }
     
+    // producer and forward counters are cumulative across restarts
     accepting_producers_.store(true, std::memory_order_release);
-    accepted_messages_.store(0, std::memory_order_relaxed);
-    forwarded_messages_.store(0, std::memory_order_relaxed);
-    active_produce_calls_.store(0, std::memory_order_relaxed);
+    
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        ready_lanes_.clear();
+    }
     
     running_.store(true);
     io_thread_ = std::thread(&PublisherBus::io_thread_loop, this);
     
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    if (!config_.await_subscriber_ids.empty()) {
+        wait_for_subscribers(config_.await_subscriber_ids, config_.ready_timeout);
+    } else if (config_.await_subscribers > 0) {
+        wait_for_subscribers(config_.await_subscribers, config_.ready_timeout);
+    }
 }
 
 void PublisherBus::stop() {
@@ -66,22 +294,84 @@ void PublisherBus::stop() {
         io_thread_.join();
     }
     
-    pull_socket_.reset();
-    pub_socket_.reset();
+    lanes_.clear();
+    credit_socket_.reset();
+}
+
+size_t PublisherBus::ready_subscribers() {
+    std::lock_guard<std::mutex> lock(ready_mutex_);
+    size_t count = 0;
+    for (const auto& [subscriber_id, instances] : ready_lanes_) {
+        if (is_ready_locked(subscriber_id)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool PublisherBus::wait_for_subscribers(size_t count, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(ready_mutex_);
+    return ready_cv_.wait_for(lock, timeout, [this, count]() {
+        size_t ready = 0;
+        for (const auto& [subscriber_id, instances] : ready_lanes_) {
+            if (is_ready_locked(subscriber_id)) {
+                ++ready;
+            }
+        }
+        return ready >= count;
+    });
+}
+
+bool PublisherBus::wait_for_subscribers(const std::vector<std::string>& subscriber_ids, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(ready_mutex_);
+    return ready_cv_.wait_for(lock, timeout, [this, &subscriber_ids]() {
+        for (const auto& id : subscriber_ids) {
+            if (!is_ready_locked(id)) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+bool PublisherBus::is_ready_locked(const std::string& subscriber_id) const {
+    auto it = ready_lanes_.find(subscriber_id);
+    if (it == ready_lanes_.end()) {
+        return false;
+    }
+    for (const auto& [instance, lanes] : it->second) {
+        if (std::find(lanes.begin(), lanes.end(), false) == lanes.end()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void PublisherBus::close_producers() {
-    accepting_producers_.store(false, std::memory_order_release);
+    accepting_producers_.store(false, std::memory_order_seq_cst);
+}
+
+bool PublisherBus::producers_idle(uint64_t& accepted) {
+    std::lock_guard<std::mutex> lock(producers_mutex_);
+    bool idle = true;
+    accepted = retired_accepted_;
+    for (const auto& counters : producer_counters_) {
+        if (counters->in_produce.load(std::memory_order_seq_cst)) {
+            idle = false;
+        }
+        accepted += counters->accepted.load(std::memory_order_acquire);
+    }
+    return idle;
 }
 
 bool PublisherBus::wait_drained(std::chrono::milliseconds timeout) {
     auto is_drained = [this]() {
-        const bool producers_closed = !accepting_producers_.load(std::memory_order_acquire);
-        const uint64_t active_calls = active_produce_calls_.load(std::memory_order_acquire);
-        const uint64_t accepted = accepted_messages_.load(std::memory_order_acquire);
+        const bool producers_closed = !accepting_producers_.load(std::memory_order_seq_cst);
+        uint64_t accepted = 0;
+        const bool idle = producers_idle(accepted);
         const uint64_t forwarded = forwarded_messages_.load(std::memory_order_acquire);
 
-        return producers_closed && active_calls == 0 && forwarded >= accepted;
+        return producers_closed && idle && forwarded >= accepted;
     };
 
     if (timeout == std::chrono::milliseconds::max()) {
@@ -101,95 +391,214 @@ bool PublisherBus::wait_drained(std::chrono::milliseconds timeout) {
     return is_drained();
 }
 
+void PublisherBus::retire_producer(Producer::Counters& counters) {
+    // in_produce is false: the producer is being destroyed by its own thread
+    std::lock_guard<std::mutex> lock(producers_mutex_);
+    retired_accepted_ += counters.accepted.load(std::memory_order_acquire);
+    auto it = std::find_if(producer_counters_.begin(), producer_counters_.end(),
+                           [&counters](const auto& entry) { return entry.get() == &counters; });
+    if (it != producer_counters_.end()) {
+        std::swap(*it, producer_counters_.back());
+        producer_counters_.pop_back();
+    }
+}
+
+Producer PublisherBus::make_producer() {
+    std::lock_guard<std::mutex> lock(producers_mutex_);
+    producer_counters_.push_back(std::make_unique<Producer::Counters>());
+    return Producer(*this, *producer_counters_.back());
+}
+
 bool PublisherBus::produce(const Message& msg) {
-    if (!running_.load()) {
-        return false;
+    return get_thread_local_producer().produce(msg.topic, msg.payload);
+}
+
+void PublisherBus::io_thread_loop() {
+    while (running_.load()) {
+        if (io_paused_.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        
+        bool had_control = false;
+        for (size_t lane = 0; lane < lanes_.size(); ++lane) {
+            had_control |= poll_subscriptions(lane);
+        }
+        if (flow_control_) {
+            had_control |= poll_credits();
+        }
+        
+        // strict priority: one message per pass, from the highest non-empty lane
+        bool had_message = false;
+        for (size_t lane = 0; lane < lanes_.size() && !had_message; ++lane) {
+            had_message = forward_one(lane);
+        }
+        
+        if (!had_message && !had_control) {
+            // no message available, wait briefly
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
     }
+}
+
+bool PublisherBus::forward_one(size_t lane) {
+    auto& pub_socket = *lanes_[lane].pub_socket;
     
-    if (!accepting_producers_.load(std::memory_order_acquire)) {
+    std::vector<zmq::message_t> msgs;
+    auto result = zmq::recv_multipart(*lanes_[lane].pull_socket, std::back_inserter(msgs), zmq::recv_flags::dontwait);
+    if (!result.has_value()) {
         return false;
     }
-
-    active_produce_calls_.fetch_add(1, std::memory_order_acq_rel);
-    if (!accepting_producers_.load(std::memory_order_acquire)) {
-        active_produce_calls_.fetch_sub(1, std::memory_order_acq_rel);
-        return false;
+    if (msgs.size() < 2) {
+        return true;
     }
     
-    bool sent = false;
+    uint64_t message_id = 0;
+    bool last_of_message = true;
+    if (msgs.size() >= 3 && msgs[2].size() == sizeof(WireHeader)) {
+        // header frames are owned by this thread until sent, so stamp in place
+        auto* header = static_cast<WireHeader*>(msgs[2].data());
+        header->forward_ticks = TscClock::now();
+        message_id = header->produce_ticks;
+        
+        if ((header->flags & kWireFlagFragment) && msgs.size() >= 4 && msgs[3].size() == sizeof(FragmentHeader)) {
+            FragmentHeader fragment;
+            std::memcpy(&fragment, msgs[3].data(), sizeof(fragment));
+            last_of_message = fragment.index + 1 == fragment.count;
+        }
+    }
+    const size_t payload_size = msgs[1].size();
+    
+    // a fragmented message is accepted, charged and counted once, on its last
+    // chunk; charge before sending, which empties the frames
+    if (last_of_message && flow_control_) {
+        flow_control_->on_forward(std::string_view(static_cast<const char*>(msgs[0].data()), msgs[0].size()));
+    }
     
-    auto& push_socket = get_thread_local_push_socket();
     try {
-        zmq::message_t topic_msg(msg.topic.size());
-        std::memcpy(topic_msg.data(), msg.topic.data(), msg.topic.size());
-        push_socket.send(topic_msg, zmq::send_flags::sndmore);
-        
-        zmq::message_t payload_msg(msg.payload.size());
-        std::memcpy(payload_msg.data(), msg.payload.data(), msg.payload.size());
-        push_socket.send(payload_msg, zmq::send_flags::none);
+        for (size_t i = 0; i + 1 < msgs.size(); ++i) {
+            pub_socket.send(msgs[i], zmq::send_flags::sndmore);
+        }
+        pub_socket.send(msgs.back(), zmq::send_flags::none);
+        flight_recorder_.record(FlightEventType::Forward, message_id, payload_size, static_cast<uint16_t>(lane));
         
-        sent = true;
+        if (last_of_message) {
+            forwarded_messages_.fetch_add(1, std::memory_order_release);
+        }
     } catch (const zmq::error_t&) {
-        sent = false;
+        // sends only fail while the bus is shutting down
+    }
+    return true;
+}
+
+bool PublisherBus::poll_credits() {
+    flow_control_->expire();
+    
+    std::vector<zmq::message_t> msgs;
+    auto result = zmq::recv_multipart(*credit_socket_, std::back_inserter(msgs), zmq::recv_flags::dontwait);
+    if (!result.has_value()) {
+        return false;
+    }
+    if (msgs.size() < 2 || msgs[1].size() != sizeof(CreditGrant)) {
+        return true;
     }
     
-    if (sent) {
-        accepted_messages_.fetch_add(1, std::memory_order_release);
+    CreditGrant grant;
+    std::memcpy(&grant, msgs[1].data(), sizeof(grant));
+    
+    std::vector<std::string> prefixes;
+    prefixes.reserve(msgs.size() - 2);
+    for (size_t i = 2; i < msgs.size(); ++i) {
+        prefixes.emplace_back(static_cast<const char*>(msgs[i].data()), msgs[i].size());
     }
-    active_produce_calls_.fetch_sub(1, std::memory_order_acq_rel);
     
-    return sent;
+    flow_control_->on_grant(msgs[0].to_string(), grant, std::move(prefixes));
+    return true;
 }
 
-void PublisherBus::io_thread_loop() {
-    while (running_.load()) {
-        std::vector<zmq::message_t> msgs;
-        auto result = zmq::recv_multipart(*pull_socket_, std::back_inserter(msgs), zmq::recv_flags::dontwait);
+FlowControl::State PublisherBus::flow_control_state() {
+    return flow_control_ ? flow_control_->state() : FlowControl::State{};
+}
+
+bool PublisherBus::poll_subscriptions(size_t lane) {
+    auto& pub_socket = *lanes_[lane].pub_socket;
+    
+    zmq::message_t event;
+    auto result = pub_socket.recv(event, zmq::recv_flags::dontwait);
+    if (!result.has_value()) {
+        return false;
+    }
+    
+    // XPUB notifications are a subscribe (1) / unsubscribe (0) byte followed by the topic
+    if (event.size() <= kReadyTopicPrefix.size()) {
+        return true;
+    }
+    const char* data = static_cast<const char*>(event.data());
+    const std::string_view topic(data + 1, event.size() - 1);
+    std::string_view subscriber_id;
+    std::string_view instance;
+    if (!parse_ready_topic(topic, subscriber_id, instance)) {
+        return true;
+    }
+    
+    if (data[0] == 1) {
+        try {
+            zmq::message_t welcome_topic(topic.data(), topic.size());
+            zmq::message_t welcome_payload;
+            pub_socket.send(welcome_topic, zmq::send_flags::sndmore);
+            pub_socket.send(welcome_payload, zmq::send_flags::none);
+        } catch (const zmq::error_t&) {
+            // a lost welcome only delays the subscriber until its ready_timeout
+        }
         
-        if (result.has_value() && msgs.size() >= 2) {
-            try {
-                pub_socket_->send(msgs[0], zmq::send_flags::sndmore);
-                pub_socket_->send(msgs[1], zmq::send_flags::none);
-                forwarded_messages_.fetch_add(1, std::memory_order_release);
-            } catch (const zmq::error_t&) {
-                if (!running_.load()) {
-                    break;
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        auto& lanes = ready_lanes_[std::string(subscriber_id)][std::string(instance)];
+        lanes.resize(lanes_.size(), false);
+        lanes[lane] = true;
+    } else {
+        // only the instance that unsubscribed loses readiness; a newer one
+        // with the same id keeps its own entry
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        auto it = ready_lanes_.find(std::string(subscriber_id));
+        if (it != ready_lanes_.end()) {
+            auto instance_it = it->second.find(std::string(instance));
+            if (instance_it != it->second.end()) {
+                instance_it->second[lane] = false;
+                if (std::find(instance_it->second.begin(), instance_it->second.end(), true) == instance_it->second.end()) {
+                    it->second.erase(instance_it);
                 }
             }
-        } else {
-            // no message available, wait briefly
-            std::this_thread::sleep_for(std::chrono::microseconds(10));
+            if (it->second.empty()) {
+                ready_lanes_.erase(it);
+            }
         }
     }
+    ready_cv_.notify_all();
+    return true;
 }
 
-zmq::socket_t& PublisherBus::get_thread_local_push_socket() {
-    auto& cache = g_push_socket_cache[this];
-    if (cache.bus_token == cache_token_ && cache.socket != nullptr) {
-        return *cache.socket;
-    }
+bool PublisherBus::dump_flight_recorder(const std::string& path) const {
+    return flight_recorder_.dump(path, "publisher");
+}
 
-    if (cache.bus_token != cache_token_) {
-        cache.bus_token = cache_token_;
-        cache.owner_id = next_socket_owner_id_.fetch_add(1, std::memory_order_relaxed);
-        cache.socket = nullptr;
+Producer& PublisherBus::get_thread_local_producer() {
+    if (g_last_producer_bus == this && g_last_producer.bus_token == cache_token_) {
+        return *g_last_producer.producer;
     }
 
-    std::lock_guard<std::mutex> lock(socket_mutex_);
-
-    auto it = thread_sockets_.find(cache.owner_id);
-    if (it == thread_sockets_.end()) {
-        auto socket = std::make_unique<zmq::socket_t>(context_, zmq::socket_type::push);
-        socket->set(zmq::sockopt::sndhwm, config_.hwm);
-        socket->connect(config_.inproc_ingress);
+    auto& cache = g_producer_cache[this];
+    if (cache.bus_token != cache_token_ || cache.producer == nullptr) {
+        auto producer = std::make_unique<Producer>(make_producer());
+        cache.bus_token = cache_token_;
+        cache.producer = producer.get();
 
-        auto [inserted, _] = thread_sockets_.emplace(cache.owner_id, std::move(socket));
-        cache.socket = inserted->second.get();
-        return *cache.socket;
+        std::lock_guard<std::mutex> lock(producers_mutex_);
+        implicit_producers_.push_back(std::move(producer));
     }
 
-    cache.socket = it->second.get();
-    return *cache.socket;
+    g_last_producer_bus = this;
+    g_last_producer = cache;
+    return *cache.producer;
 }
 
 } // namespace messenger
@@ -1,22 +1,94 @@
 #pragma once
 
 #include "types.hpp"
+#include "lanes.hpp"
+#include "flow_control.hpp"
+#include "flight_recorder.hpp"
 #include <zmq.hpp>
 #include <zmq_addon.hpp>
 #include <thread>
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace messenger {
 
+class PublisherBus;
+
+/**
+ * Producer is an explicit per-thread handle for publishing into a PublisherBus.
+ *
+ * It owns one PUSH socket per lane and a cache-line-padded counter block, so
+ * producers never write a cache line shared with other producers. It must be
+ * used by one thread at a time and must not outlive its PublisherBus.
+ */
+class Producer {
+public:
+    Producer(Producer&& other) noexcept;
+    Producer& operator=(Producer&& other) noexcept;
+    ~Producer();
+    
+    Producer(const Producer&) = delete;
+    Producer& operator=(const Producer&) = delete;
+    
+    // Returns false if producers are closed, the bus is not running, ingress is
+    // full, or flow control refused the topic
+    bool produce(const Message& message);
+    
+    bool produce(std::string_view topic, std::string_view payload);
+    
+    // Builds the payload directly in the outgoing frame: fill(void* data)
+    // must write exactly `size` bytes. Saves the copy out of a caller buffer
+    template <typename Fill>
+    bool produce_in_place(std::string_view topic, size_t size, Fill&& fill) {
+        zmq::message_t payload(size);
+        fill(payload.data());
+        return send(topic, payload);
+    }
+    
+    // Messages this producer handed to the bus
+    uint64_t accepted() const;
+
+private:
+    friend class PublisherBus;
+    
+    // Written only by the owning producer, read by PublisherBus::wait_drained()
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> accepted{0};
+        std::atomic<bool> in_produce{false};
+    };
+    
+    Producer(PublisherBus& bus, Counters& counters);
+    
+    bool send(std::string_view topic, zmq::message_t& payload);
+    
+    // Sends the payload as FragmentHeader-tagged chunks that reference it
+    // instead of copying it
+    void send_fragments(zmq::socket_t& socket, std::string_view topic, zmq::message_t& payload,
+                        uint64_t produce_ticks);
+    
+    zmq::socket_t& push_socket(size_t lane);
+    
+    PublisherBus* bus_;
+    Counters* counters_;
+    std::vector<std::unique_ptr<zmq::socket_t>> push_sockets_;  // indexed by lane
+};
+
 /**
  * PublisherBus implements the publisher side of the messaging bus.
  * 
  * Architecture:
- * - Producer threads: Each has a thread-local PUSH socket connected to inproc://ingress
- * - I/O thread: Owns PULL socket (bound to inproc://ingress) and PUB socket (bound to TCP)
+ * - Producer threads: Each uses a Producer (explicit via make_producer(), or an implicit
+ *   thread-local one behind produce()) owning a PUSH socket per lane connected to the lane's inproc ingress
+ * - I/O thread: Owns a PULL socket (inproc ingress) and XPUB socket (bound to TCP) per priority lane,
+ *   and always forwards from the highest-priority non-empty lane first
+ * - XPUB subscription notifications drive the readiness handshake (see wire.hpp)
+ * - Optional credit-based flow control: a PULL socket receives subscriber
+ *   credit grants and produce() is gated per topic (see FlowControl)
  * - No socket sharing across threads (ZeroMQ sockets are not thread-safe)
  */
 class PublisherBus {
@@ -24,46 +96,115 @@ public:
     explicit PublisherBus(const BusConfig& config = BusConfig{});
     ~PublisherBus();
     
+    // Returns once sockets are bound, after waiting for the subscribers
+    // configured in BusConfig::await_subscribers / await_subscriber_ids (if any)
     void start();
     
     void stop();
     
+    // Number of subscribers that completed the readiness handshake
+    size_t ready_subscribers();
+    
+    // Wait until at least `count` subscribers are ready
+    bool wait_for_subscribers(size_t count, std::chrono::milliseconds timeout);
+    
+    // Wait until every subscriber in `subscriber_ids` is ready
+    bool wait_for_subscribers(const std::vector<std::string>& subscriber_ids, std::chrono::milliseconds timeout);
+    
     // Disallow new produce() calls from being accepted
     void close_producers();
     
     // Wait until all accepted messages have been forwarded by the I/O thread
     bool wait_drained(std::chrono::milliseconds timeout = std::chrono::milliseconds::max());
     
+    // Creates a producer handle for the calling thread; must not outlive the bus
+    Producer make_producer();
+    
+    // Convenience wrapper over a thread-local Producer owned by the bus.
     // Returns false if producers are closed or the bus is not running
     bool produce(const Message& message);
     
     bool is_running() const { return running_.load(); }
+    
+    // Messages the I/O thread handed to its XPUB sockets (they may still be
+    // dropped there at the HWM)
+    uint64_t forwarded_messages() const { return forwarded_messages_.load(); }
+    
+    // Fault injection: while paused the I/O thread stops reading its sockets
+    void set_io_paused(bool paused) { io_paused_.store(paused); }
+    
+    // Credit and throttle state; empty unless BusConfig::flow_control is enabled
+    FlowControl::State flow_control_state();
+    
+    // Writes the flight recorder's recent events (see FlightRecorder)
+    bool dump_flight_recorder(const std::string& path) const;
 
 private:
+    friend class Producer;
+    
     void io_thread_loop();
     
-    zmq::socket_t& get_thread_local_push_socket();
+    // Forwards one message from the lane's ingress; returns true if one was read
+    bool forward_one(size_t lane);
+    
+    // Handles XPUB subscribe/unsubscribe notifications; returns true if one was read
+    bool poll_subscriptions(size_t lane);
+    
+    // Applies pending credit grants; returns true if one was read
+    bool poll_credits();
+    
+    bool is_ready_locked(const std::string& subscriber_id) const;
+    
+    Producer& get_thread_local_producer();
+    
+    // Sums per-producer counters; true if no produce() is in flight
+    bool producers_idle(uint64_t& accepted);
+    
+    // Called by ~Producer: folds its count into retired_accepted_ and frees its counters
+    void retire_producer(Producer::Counters& counters);
     
     BusConfig config_;
+    FlightRecorder flight_recorder_;
     zmq::context_t context_;
     
-    std::unique_ptr<zmq::socket_t> pull_socket_;
-    std::unique_ptr<zmq::socket_t> pub_socket_;
+    struct Lane {
+        std::unique_ptr<zmq::socket_t> pull_socket;
+        std::unique_ptr<zmq::socket_t> pub_socket;
+    };
+    std::vector<Lane> lanes_;
+    
+    std::unique_ptr<FlowControl> flow_control_;
+    std::unique_ptr<zmq::socket_t> credit_socket_;
+    
+    // lanes on which each subscriber instance completed the readiness handshake,
+    // by subscriber id then instance nonce; a subscriber is ready once one of
+    // its instances completed it on every lane
+    std::mutex ready_mutex_;
+    std::condition_variable ready_cv_;
+    std::unordered_map<std::string, std::unordered_map<std::string, std::vector<bool>>> ready_lanes_;
     
     std::atomic<bool> running_{false};
+    std::atomic<bool> io_paused_{false};
     std::thread io_thread_;
 
-    // for thread-local sockets (per PublisherBus object)
+    // counters of live producers; a destroyed producer's messages stay
+    // visible to wait_drained() through retired_accepted_
+    std::mutex producers_mutex_;
+    std::vector<std::unique_ptr<Producer::Counters>> producer_counters_;
+    uint64_t retired_accepted_ = 0;
+    
+    // producers behind produce(), one per calling thread (per PublisherBus object);
+    // declared after context_ so their sockets close before it terminates
     const uint64_t cache_token_;
-    std::atomic<uint64_t> next_socket_owner_id_{1};
-    std::mutex socket_mutex_;
-    std::unordered_map<uint64_t, std::unique_ptr<zmq::socket_t>> thread_sockets_;
+    std::vector<std::unique_ptr<Producer>> implicit_producers_;
     
     // for correct stopping conditions
     std::atomic<bool> accepting_producers_{false};
-    std::atomic<uint64_t> accepted_messages_{0};
-    std::atomic<uint64_t> forwarded_messages_{0};
-    std::atomic<uint64_t> active_produce_calls_{0};
+    std::atomic<uint64_t> forwarded_messages_{0};  // fragmented messages count once
+    
+    // FragmentHeader::stream_id source; randomly seeded so subscribers
+    // connected to several publishers can tell their streams apart
+    std::atomic<uint64_t> next_stream_id_;
 };
 
 } // namespace messenger
@@ -0,0 +1,143 @@
+#include "reassembly.hpp"
+#include "tsc_clock.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace messenger {
+
+BufferPool::BufferPool(size_t max_buffers)
+    : max_buffers_(max_buffers) {
+}
+
+std::string BufferPool::acquire(size_t size) {
+    std::string buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            buffer = std::move(free_.back());
+            free_.pop_back();
+        }
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void BufferPool::release(std::string&& buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() < max_buffers_) {
+        free_.push_back(std::move(buffer));
+    }
+}
+
+Reassembler::Reassembler(BufferPool& pool, size_t max_size)
+    : pool_(pool)
+    , max_size_(max_size) {
+}
+
+Reassembler::AddResult Reassembler::add(std::string_view topic, const FragmentHeader& fragment,
+                                        std::string_view chunk, uint64_t message_id, uint64_t now_ticks,
+                                        Completed& completed) {
+    if (fragment.count == 0 || fragment.index >= fragment.count
+        || fragment.offset > fragment.total_size || chunk.size() > fragment.total_size - fragment.offset) {
+        return AddResult::Ignored;
+    }
+    
+    if (fragment.total_size > max_size_) {
+        const bool first_seen = oversized_.count(fragment.stream_id) == 0;
+        if (fragment.index + 1 == fragment.count) {
+            oversized_.erase(fragment.stream_id);
+        } else {
+            oversized_[fragment.stream_id] = now_ticks;
+        }
+        return first_seen ? AddResult::Oversized : AddResult::Ignored;
+    }
+    
+    // every chunk but the last is non-empty, which also bounds `arrived`
+    if (fragment.count > std::max<uint64_t>(1, fragment.total_size)) {
+        return AddResult::Ignored;
+    }
+    
+    // the sender cuts fixed-size chunks: all but the last are chunk_size long
+    // at index * chunk_size, and the last one ends the payload
+    const bool last = fragment.index + 1 == fragment.count;
+    uint64_t chunk_size = 0;
+    if (!last) {
+        chunk_size = chunk.size();
+        if (chunk_size == 0 || fragment.offset != static_cast<uint64_t>(fragment.index) * chunk_size) {
+            return AddResult::Ignored;
+        }
+    } else {
+        if (fragment.offset + chunk.size() != fragment.total_size) {
+            return AddResult::Ignored;
+        }
+        if (fragment.index == 0) {
+            if (fragment.offset != 0) {
+                return AddResult::Ignored;
+            }
+        } else {
+            chunk_size = fragment.offset / fragment.index;
+            if (fragment.offset % fragment.index != 0 || chunk.size() > chunk_size) {
+                return AddResult::Ignored;
+            }
+        }
+    }
+    
+    auto it = partials_.find(fragment.stream_id);
+    if (it == partials_.end()) {
+        Partial partial;
+        partial.topic = std::string(topic);
+        partial.payload = pool_.acquire(fragment.total_size);
+        partial.message_id = message_id;
+        partial.count = fragment.count;
+        partial.arrived.assign(fragment.count, false);
+        it = partials_.emplace(fragment.stream_id, std::move(partial)).first;
+    }
+    
+    Partial& partial = it->second;
+    if (partial.count != fragment.count || partial.payload.size() != fragment.total_size
+        || partial.arrived[fragment.index]
+        || (chunk_size != 0 && partial.chunk_size != 0 && chunk_size != partial.chunk_size)) {
+        return AddResult::Ignored;
+    }
+    if (chunk_size != 0) {
+        partial.chunk_size = chunk_size;
+    }
+    
+    std::memcpy(partial.payload.data() + fragment.offset, chunk.data(), chunk.size());
+    partial.arrived[fragment.index] = true;
+    partial.received_bytes += chunk.size();
+    partial.last_ticks = now_ticks;
+    
+    // every index but too few bytes means the chunks left holes; such a
+    // message never completes and is reported when it expires
+    if (++partial.received < partial.count || partial.received_bytes != fragment.total_size) {
+        return AddResult::Pending;
+    }
+    
+    completed = Completed{std::move(partial.topic), std::move(partial.payload)};
+    partials_.erase(it);
+    return AddResult::Complete;
+}
+
+std::vector<uint64_t> Reassembler::expire(uint64_t now_ticks, std::chrono::nanoseconds timeout) {
+    std::vector<uint64_t> expired;
+    for (auto it = partials_.begin(); it != partials_.end();) {
+        if (TscClock::elapsed(it->second.last_ticks, now_ticks) >= timeout) {
+            expired.push_back(it->second.message_id);
+            pool_.release(std::move(it->second.payload));
+            it = partials_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = oversized_.begin(); it != oversized_.end();) {
+        if (TscClock::elapsed(it->second, now_ticks) >= timeout) {
+            it = oversized_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return expired;
+}
+
+} // namespace messenger
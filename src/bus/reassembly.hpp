@@ -0,0 +1,92 @@
+#pragma once
+
+#include "wire.hpp"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace messenger {
+
+/**
+ * Reusable payload buffers for reassembled messages.
+ *
+ * The subscriber I/O thread acquires a buffer per fragmented message and the
+ * worker returns it after the handler ran, so large messages stop allocating
+ * (and faulting in) fresh memory once the pool is warm.
+ */
+class BufferPool {
+public:
+    explicit BufferPool(size_t max_buffers);
+    
+    // Returns a buffer resized to `size`; only bytes beyond a reused buffer's
+    // previous size are zero-filled
+    std::string acquire(size_t size);
+    
+    void release(std::string&& buffer);
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> free_;
+    const size_t max_buffers_;
+};
+
+/**
+ * Subscriber-side reassembly of fragmented messages (see FragmentHeader).
+ * Owned by the I/O thread. Chunks may interleave with other messages and
+ * with chunks of other fragmented messages.
+ */
+class Reassembler {
+public:
+    struct Completed {
+        std::string topic;
+        std::string payload;  // from the BufferPool; release it after use
+    };
+    
+    enum class AddResult {
+        Pending,    // stored; more chunks to come
+        Complete,   // `completed` holds the message
+        Ignored,    // inconsistent, duplicate or overlapping chunk, or a later
+                    // chunk of an oversized message
+        Oversized,  // first chunk of a message above max_size; report it dropped
+    };
+    
+    Reassembler(BufferPool& pool, size_t max_size);
+    
+    // Copies the chunk into its message's buffer. Every chunk but the last
+    // must have the same size and sit at index * that size, and the last must
+    // end at total_size, so a complete message has no holes or overlaps.
+    // message_id is the produce stamp, kept to report the message if it expires
+    AddResult add(std::string_view topic, const FragmentHeader& fragment, std::string_view chunk,
+                  uint64_t message_id, uint64_t now_ticks, Completed& completed);
+    
+    // Discards messages that got no chunk for `timeout`; returns their message ids
+    std::vector<uint64_t> expire(uint64_t now_ticks, std::chrono::nanoseconds timeout);
+    
+    size_t pending() const { return partials_.size(); }
+
+private:
+    struct Partial {
+        std::string topic;
+        std::string payload;
+        uint64_t message_id = 0;
+        uint32_t count = 0;
+        uint32_t received = 0;
+        uint64_t received_bytes = 0;
+        uint64_t chunk_size = 0;    // 0 until a chunk reveals it
+        std::vector<bool> arrived;  // by chunk index
+        uint64_t last_ticks = 0;
+    };
+    
+    BufferPool& pool_;
+    const size_t max_size_;
+    std::unordered_map<uint64_t, Partial> partials_;  // by stream_id
+    // oversized messages already reported, so later chunks stay quiet;
+    // stream_id -> last chunk ticks, forgotten like partials
+    std::unordered_map<uint64_t, uint64_t> oversized_;
+};
+
+} // namespace messenger
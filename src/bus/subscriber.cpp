@@ -1,18 +1,63 @@
 #include "subscriber.hpp"
+#include "tsc_clock.hpp"
+#include "wire.hpp"
 #include <zmq_addon.hpp>
 #include <iostream>
 #include <chrono>
 #include <sstream>
+#include <cstring>
+#include <random>
+#include <algorithm>
+#include <charconv>
 
 namespace messenger {
 
+namespace {
+constexpr size_t kMaxTimestampDigits = 20;
+
+std::string generate_random_id() {
+    std::random_device rd;
+    std::mt19937_64 rng((static_cast<uint64_t>(rd()) << 32) ^ rd()
+                        ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::ostringstream oss;
+    oss << std::hex << rng();
+    return oss.str();
+}
+}
+
 SubscriberBus::SubscriberBus(const BusConfig& config, const std::vector<std::string>& topics, MessageHandler handler)
+    : SubscriberBus(config, topics, handler, make_executor(config)) {
+}
+
+SubscriberBus::SubscriberBus(const BusConfig& config, const std::vector<std::string>& topics, MessageHandler handler,
+                             std::unique_ptr<Executor> executor)
     : config_(config)
+    , flight_recorder_(config.flight_recorder_events, config.flight_recorder_path)
     , topics_(topics)
     , handler_(handler)
     , context_(config.io_threads)
-    , worker_pool_(config.worker_threads)
-    , metrics_(config.metrics_period) {
+    , executor_(std::move(executor))
+    , metrics_(config.metrics_period)
+    , buffer_pool_(config.reassembly_pool_buffers)
+    , reassembler_(buffer_pool_, config.reassembly_max_size) {
+    if (config_.subscriber_id.empty()) {
+        config_.subscriber_id = generate_random_id();
+    }
+    // keep the calibration spin out of the first receive
+    TscClock::calibrate_now();
+    // a zero bound would never read a message in batch mode
+    config_.batch_max_messages = std::max<size_t>(1, config_.batch_max_messages);
+    flight_recorder_.watch_dump_requests(config_.subscriber_id);
+}
+
+SubscriberBus::SubscriberBus(const BusConfig& config, const std::vector<std::string>& topics, BatchHandler handler)
+    : SubscriberBus(config, topics, std::move(handler), make_executor(config)) {
+}
+
+SubscriberBus::SubscriberBus(const BusConfig& config, const std::vector<std::string>& topics, BatchHandler handler,
+                             std::unique_ptr<Executor> executor)
+    : SubscriberBus(config, topics, MessageHandler{}, std::move(executor)) {
+    batch_handler_ = std::move(handler);
 }
 
 SubscriberBus::~SubscriberBus() {
@@ -24,20 +69,60 @@ void SubscriberBus::start() {
         return;
     }
     
-    sub_socket_.reset(new zmq::socket_t(context_, zmq::socket_type::sub));
-    sub_socket_->set(zmq::sockopt::rcvhwm, config_.hwm);
-    
-    sub_socket_->connect(config_.sub_connect_addr);
+    const size_t lanes = lane_count(config_);
+    sub_sockets_.clear();
+    credit_socket_.reset();
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        auto socket = std::make_unique<zmq::socket_t>(context_, zmq::socket_type::sub);
+        socket->set(zmq::sockopt::rcvhwm, config_.hwm);
+        socket->connect(lane_sub_connect_addr(config_, lane));
+        sub_sockets_.push_back(std::move(socket));
+    }
     
     for (const auto& topic : topics_) {
-        sub_socket_->set(zmq::sockopt::subscribe, topic);
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            if (lane_carries_subscription(config_, lane, topic)) {
+                sub_sockets_[lane]->set(zmq::sockopt::subscribe, topic);
+            }
+        }
+    }
+    // must follow the data topics: subscriptions reach the publisher in order
+    ready_topic_ = ready_topic(config_.subscriber_id, generate_random_id());
+    for (auto& socket : sub_sockets_) {
+        socket->set(zmq::sockopt::subscribe, ready_topic_);
     }
     
+    if (config_.flow_control != FlowControlMode::None) {
+        credit_socket_.reset(new zmq::socket_t(context_, zmq::socket_type::push));
+        // grants are soft state: never queue many or block shutdown on them
+        credit_socket_->set(zmq::sockopt::sndhwm, 16);
+        credit_socket_->set(zmq::sockopt::linger, 0);
+        credit_socket_->connect(config_.credit_connect_addr);
+        
+        credit_epoch_ = TscClock::now();
+        last_granted_completed_ = 0;
+        last_grant_ticks_ = 0;
+    }
+    received_messages_.store(0);
+    completed_messages_.store(0);
+    dropped_messages_.store(0);
+    
+    lane_ready_.assign(lanes, false);
+    urgent_lanes_ = std::vector<UrgentLane>(lanes - 1);
+    urgent_pending_.store(0);
+    ready_.store(false);
     running_.store(true);
     start_time_ = std::chrono::steady_clock::now();
     io_thread_ = std::thread(&SubscriberBus::io_thread_loop, this);
     
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (config_.await_ready) {
+        wait_ready(config_.ready_timeout);
+    }
+}
+
+bool SubscriberBus::wait_ready(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(ready_mutex_);
+    return ready_cv_.wait_for(lock, timeout, [this]() { return ready_.load(); });
 }
 
 void SubscriberBus::stop() {
@@ -51,49 +136,530 @@ void SubscriberBus::stop() {
         io_thread_.join();
     }
     
-    worker_pool_.join();
+    executor_->join();
     
-    sub_socket_.reset();
+    sub_sockets_.clear();
+    credit_socket_.reset();
 }
 
 void SubscriberBus::io_thread_loop() {
     while (running_.load()) {
+        if (io_paused_.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        
+        // strict priority: one message per pass, from the highest non-empty lane
+        bool had_message = false;
+        for (size_t lane = 0; lane < sub_sockets_.size() && !had_message; ++lane) {
+            had_message = batch_handler_ ? receive_batch(lane) : receive_one(lane);
+        }
+        
+        if (credit_socket_) {
+            maybe_grant_credit();
+        }
+        
+        if (reassembler_.pending() > 0 || !chunk_streams_.empty()) {
+            expire_fragments();
+        }
+        
+        if (!had_message) {
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+    }
+}
+
+void SubscriberBus::maybe_grant_credit() {
+    const uint64_t completed = completed_messages_.load(std::memory_order_acquire);
+    const uint64_t now = TscClock::now();
+    
+    // grant early once a quarter of the window was freed, so the publisher
+    // never stalls waiting for the periodic grant under steady load
+    const bool freed_enough = completed - last_granted_completed_ >= std::max<uint64_t>(1, config_.credit_window / 4);
+    const bool period_elapsed = TscClock::elapsed(last_grant_ticks_, now) >= config_.credit_period || last_grant_ticks_ == 0;
+    if (!freed_enough && !period_elapsed) {
+        return;
+    }
+    
+    CreditGrant grant;
+    grant.epoch = credit_epoch_;
+    grant.granted = completed + config_.credit_window;
+    grant.received = received_messages_.load(std::memory_order_relaxed);
+    grant.completed = completed;
+    
+    try {
+        // only the first frame can hit the HWM; the rest of a multipart follows it
+        zmq::message_t id_msg(config_.subscriber_id.data(), config_.subscriber_id.size());
+        zmq::message_t grant_msg(&grant, sizeof(grant));
+        if (!credit_socket_->send(id_msg, zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
+            last_grant_ticks_ = now;
+            return;
+        }
+        credit_socket_->send(grant_msg, topics_.empty() ? zmq::send_flags::dontwait
+                                                        : zmq::send_flags::sndmore | zmq::send_flags::dontwait);
+        for (size_t i = 0; i < topics_.size(); ++i) {
+            zmq::message_t prefix_msg(topics_[i].data(), topics_[i].size());
+            const bool last = i + 1 == topics_.size();
+            credit_socket_->send(prefix_msg, last ? zmq::send_flags::dontwait
+                                                  : zmq::send_flags::sndmore | zmq::send_flags::dontwait);
+        }
+    } catch (const zmq::error_t&) {
+        // the next grant supersedes this one
+    }
+    
+    last_granted_completed_ = completed;
+    last_grant_ticks_ = now;
+}
+
+namespace {
+void read_trace(const std::vector<zmq::message_t>& msgs, MessageTrace& trace) {
+    if (msgs.size() >= 3 && msgs[2].size() == sizeof(WireHeader)) {
+        WireHeader header;
+        std::memcpy(&header, msgs[2].data(), sizeof(header));
+        if (header.version == kWireVersion) {
+            trace.produce_ticks = header.produce_ticks;
+            trace.forward_ticks = header.forward_ticks;
+        }
+    }
+}
+
+bool read_fragment(const std::vector<zmq::message_t>& msgs, FragmentHeader& fragment) {
+    if (msgs.size() < 4 || msgs[2].size() != sizeof(WireHeader) || msgs[3].size() != sizeof(FragmentHeader)) {
+        return false;
+    }
+    WireHeader header;
+    std::memcpy(&header, msgs[2].data(), sizeof(header));
+    if (header.version != kWireVersion || (header.flags & kWireFlagFragment) == 0) {
+        return false;
+    }
+    std::memcpy(&fragment, msgs[3].data(), sizeof(fragment));
+    return true;
+}
+
+std::string_view frame_view(const zmq::message_t& frame) {
+    return std::string_view(static_cast<const char*>(frame.data()), frame.size());
+}
+}
+
+// Frames stay in place (vectors of frames are only moved as a whole), so the
+// views keep pointing at valid data for the lifetime of the batch; reassembled
+// messages live in a deque for the same reason
+struct SubscriberBus::Batch {
+    std::vector<std::vector<zmq::message_t>> frames;
+    std::deque<Message> reassembled;
+    std::vector<MessageView> views;
+};
+
+struct SubscriberBus::ChunkStream {
+    struct Chunk {
+        std::vector<zmq::message_t> frames;
+        FragmentHeader fragment;
+        MessageTrace trace;
+    };
+    
+    std::mutex mutex;
+    std::deque<Chunk> chunks;
+    bool scheduled = false;   // a worker task is draining `chunks`
+    bool started = false;     // chunk 0 reached the handler; worker side
+    
+    // I/O thread only
+    uint64_t message_id = 0;
+    uint64_t last_ticks = 0;
+    bool first_arrived = false;
+};
+
+bool SubscriberBus::handle_ready_echo(size_t lane, const std::vector<zmq::message_t>& msgs) {
+    // handshake echoes are never dispatched, including other subscribers'
+    // ones that match a broad prefix subscription
+    const std::string_view first_frame = frame_view(msgs[0]);
+    if (first_frame.substr(0, kReadyTopicPrefix.size()) != kReadyTopicPrefix) {
+        return false;
+    }
+    
+    if (first_frame == ready_topic_ && !lane_ready_[lane]) {
+        lane_ready_[lane] = true;
+        if (std::find(lane_ready_.begin(), lane_ready_.end(), false) == lane_ready_.end()) {
+            {
+                std::lock_guard<std::mutex> lock(ready_mutex_);
+                ready_.store(true);
+            }
+            ready_cv_.notify_all();
+        }
+    }
+    return true;
+}
+
+bool SubscriberBus::receive_one(size_t lane) {
+    std::vector<zmq::message_t> msgs;
+    auto result = zmq::recv_multipart(*sub_sockets_[lane], std::back_inserter(msgs), zmq::recv_flags::dontwait);
+    if (!result.has_value()) {
+        return false;
+    }
+    if (msgs.size() < 2 || handle_ready_echo(lane, msgs)) {
+        return true;
+    }
+    
+    const uint64_t receive_ticks = TscClock::now();
+    
+    FragmentHeader fragment;
+    if (read_fragment(msgs, fragment)) {
+        receive_fragment(lane, msgs, fragment, receive_ticks, nullptr);
+        return true;
+    }
+    
+    std::string topic(static_cast<char*>(msgs[0].data()), msgs[0].size());
+    std::string payload(static_cast<char*>(msgs[1].data()), msgs[1].size());
+    
+    Message msg(std::move(topic), std::move(payload));
+    msg.trace.receive_ticks = receive_ticks;
+    read_trace(msgs, msg.trace);
+    received_messages_.fetch_add(1, std::memory_order_relaxed);
+    
+    const uint64_t message_id = msg.trace.produce_ticks;
+    flight_recorder_.record(FlightEventType::Receive, message_id, msg.payload.size(), static_cast<uint16_t>(lane));
+    
+    const size_t affinity = std::hash<std::string>{}(msg.topic);
+    // before the hand-off, so a worker's handler_start never sorts ahead of it
+    flight_recorder_.record(FlightEventType::Dispatch, message_id, 0, static_cast<uint16_t>(lane));
+    dispatch(lane, [this, msg = std::move(msg)]() mutable {
+        msg.trace.dequeue_ticks = TscClock::now();
+        process_message(msg);
+    }, affinity);
+    return true;
+}
+
+bool SubscriberBus::receive_batch(size_t lane) {
+    auto& socket = *sub_sockets_[lane];
+    auto batch = std::make_shared<Batch>();
+    bool had_message = false;
+    uint64_t first_ticks = 0;
+    
+    // take only what is already queued; never wait for a batch to fill up
+    while (batch->views.size() < config_.batch_max_messages) {
+        if (first_ticks != 0 && TscClock::elapsed(first_ticks, TscClock::now()) >= config_.batch_max_delay) {
+            break;
+        }
+        
         std::vector<zmq::message_t> msgs;
-        auto result = zmq::recv_multipart(*sub_socket_, std::back_inserter(msgs), zmq::recv_flags::dontwait);
-        
-        if (result.has_value() && msgs.size() >= 2) {
-            std::string topic(static_cast<char*>(msgs[0].data()), msgs[0].size());
-            std::string payload(static_cast<char*>(msgs[1].data()), msgs[1].size());
-            
-            Message msg(topic, payload);
-            
-            boost::asio::post(worker_pool_, [this, msg]() {
-                process_message(msg);
-            });
-            
+        auto result = zmq::recv_multipart(socket, std::back_inserter(msgs), zmq::recv_flags::dontwait);
+        if (!result.has_value()) {
+            break;
+        }
+        had_message = true;
+        if (msgs.size() < 2 || handle_ready_echo(lane, msgs)) {
+            continue;
+        }
+        
+        const uint64_t receive_ticks = TscClock::now();
+        if (first_ticks == 0) {
+            first_ticks = receive_ticks;
+        }
+        
+        FragmentHeader fragment;
+        if (read_fragment(msgs, fragment)) {
+            receive_fragment(lane, msgs, fragment, receive_ticks, batch.get());
+            continue;
+        }
+        
+        MessageView view;
+        view.trace.receive_ticks = receive_ticks;
+        read_trace(msgs, view.trace);
+        
+        batch->frames.push_back(std::move(msgs));
+        const auto& frames = batch->frames.back();
+        view.topic = frame_view(frames[0]);
+        view.payload = frame_view(frames[1]);
+        batch->views.push_back(view);
+        received_messages_.fetch_add(1, std::memory_order_relaxed);
+        flight_recorder_.record(FlightEventType::Receive, view.trace.produce_ticks, view.payload.size(),
+                                static_cast<uint16_t>(lane));
+    }
+    
+    if (batch->views.empty()) {
+        return had_message;
+    }
+    
+    // batch events carry the first message's id and the batch size
+    const uint64_t message_id = batch->views.front().trace.produce_ticks;
+    const size_t count = batch->views.size();
+    const size_t affinity = std::hash<std::string_view>{}(batch->views.front().topic);
+    flight_recorder_.record(FlightEventType::Dispatch, message_id, count, static_cast<uint16_t>(lane));
+    dispatch(lane, [this, batch]() {
+        process_batch(*batch);
+    }, affinity);
+    return true;
+}
+
+void SubscriberBus::receive_fragment(size_t lane, std::vector<zmq::message_t>& msgs, const FragmentHeader& fragment,
+                                     uint64_t receive_ticks, Batch* batch) {
+    MessageTrace trace;
+    trace.receive_ticks = receive_ticks;
+    read_trace(msgs, trace);
+    flight_recorder_.record(FlightEventType::Receive, trace.produce_ticks, msgs[1].size(), static_cast<uint16_t>(lane));
+    
+    if (chunk_handler_) {
+        stream_chunk(lane, msgs, fragment, trace);
+        return;
+    }
+    
+    Reassembler::Completed completed;
+    const auto result = reassembler_.add(frame_view(msgs[0]), fragment, frame_view(msgs[1]), trace.produce_ticks,
+                                         receive_ticks, completed);
+    if (result == Reassembler::AddResult::Oversized) {
+        record_drop(trace.produce_ticks, DropReason::Oversized);
+    }
+    if (result != Reassembler::AddResult::Complete) {
+        return;
+    }
+    
+    // stamps of the last chunk: the message only became available then
+    Message msg(std::move(completed.topic), std::move(completed.payload));
+    msg.trace = trace;
+    received_messages_.fetch_add(1, std::memory_order_relaxed);
+    
+    if (batch != nullptr) {
+        batch->reassembled.push_back(std::move(msg));
+        const Message& stored = batch->reassembled.back();
+        batch->views.push_back(MessageView{stored.topic, stored.payload, stored.trace});
+        return;
+    }
+    
+    const uint64_t message_id = msg.trace.produce_ticks;
+    const size_t affinity = std::hash<std::string>{}(msg.topic);
+    flight_recorder_.record(FlightEventType::Dispatch, message_id, 0, static_cast<uint16_t>(lane));
+    dispatch(lane, [this, msg = std::move(msg)]() mutable {
+        msg.trace.dequeue_ticks = TscClock::now();
+        process_message(msg);
+        buffer_pool_.release(std::move(msg.payload));
+    }, affinity);
+}
+
+void SubscriberBus::stream_chunk(size_t lane, std::vector<zmq::message_t>& msgs, const FragmentHeader& fragment,
+                                 const MessageTrace& trace) {
+    std::shared_ptr<ChunkStream>& entry = chunk_streams_[fragment.stream_id];
+    if (!entry) {
+        entry = std::make_shared<ChunkStream>();
+    }
+    std::shared_ptr<ChunkStream> stream = entry;
+    stream->message_id = trace.produce_ticks;
+    stream->last_ticks = trace.receive_ticks;
+    stream->first_arrived |= fragment.index == 0;
+    
+    const bool last = fragment.index + 1 == fragment.count;
+    const size_t affinity = std::hash<std::string_view>{}(frame_view(msgs[0]));
+    bool schedule = false;
+    // a running stream task may pick the chunk up as soon as it is queued
+    flight_recorder_.record(FlightEventType::Dispatch, trace.produce_ticks, 0, static_cast<uint16_t>(lane));
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->chunks.push_back(ChunkStream::Chunk{std::move(msgs), fragment, trace});
+        schedule = !stream->scheduled;
+        stream->scheduled = true;
+    }
+    
+    if (schedule) {
+        dispatch(lane, [this, stream]() {
+            run_chunk_stream(*stream);
+        }, affinity);
+    }
+    
+    if (last) {
+        // chunks still reach the handler, but a stream without its first
+        // chunk was never counted as received, so it cannot complete either
+        if (stream->first_arrived) {
+            received_messages_.fetch_add(1, std::memory_order_relaxed);
         } else {
-            std::this_thread::sleep_for(std::chrono::microseconds(10));
+            record_drop(stream->message_id, DropReason::Incomplete);
         }
+        chunk_streams_.erase(fragment.stream_id);
     }
 }
 
-void SubscriberBus::process_message(const Message& msg) {
-    metrics_.record_message_processed();
+void SubscriberBus::run_chunk_stream(ChunkStream& stream) {
+    while (true) {
+        ChunkStream::Chunk chunk;
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            if (stream.chunks.empty()) {
+                stream.scheduled = false;
+                return;
+            }
+            chunk = std::move(stream.chunks.front());
+            stream.chunks.pop_front();
+        }
+        
+        ChunkView view;
+        view.topic = frame_view(chunk.frames[0]);
+        view.data = frame_view(chunk.frames[1]);
+        view.stream_id = chunk.fragment.stream_id;
+        view.offset = chunk.fragment.offset;
+        view.total_size = chunk.fragment.total_size;
+        view.last = chunk.fragment.index + 1 == chunk.fragment.count;
+        chunk.trace.dequeue_ticks = TscClock::now();
+        
+        // the message counts as received at its first chunk and completed at
+        // its last; chunks run in order, so only a started stream completes
+        if (chunk.fragment.index == 0) {
+            stream.started = true;
+            record_received(view.data, 1);
+        }
+        
+        flight_recorder_.record(FlightEventType::HandlerStart, chunk.trace.produce_ticks);
+        chunk_handler_(view);
+        flight_recorder_.record(FlightEventType::HandlerEnd, chunk.trace.produce_ticks);
+        
+        if (view.last && stream.started) {
+            record_completed(chunk.trace, 1);
+        }
+    }
+}
+
+void SubscriberBus::expire_fragments() {
+    // timeouts are seconds long, so a scan every 100 ms is plenty
+    const uint64_t now = TscClock::now();
+    if (last_fragment_expiry_ticks_ != 0
+        && TscClock::elapsed(last_fragment_expiry_ticks_, now) < std::chrono::milliseconds(100)) {
+        return;
+    }
+    last_fragment_expiry_ticks_ = now;
+    
+    const std::chrono::nanoseconds timeout = config_.reassembly_timeout;
+    for (uint64_t message_id : reassembler_.expire(now, timeout)) {
+        record_drop(message_id, DropReason::Incomplete);
+    }
     
-    size_t pipe_pos = msg.payload.find('|');
-    if (pipe_pos != std::string::npos) {
-        uint64_t ts = std::stoull(msg.payload.substr(0, pipe_pos));
+    // streamed messages already reached the handler chunk by chunk; only
+    // forget them. Their last chunk never arrived, so they never completed
+    for (auto it = chunk_streams_.begin(); it != chunk_streams_.end();) {
+        if (TscClock::elapsed(it->second->last_ticks, now) >= timeout) {
+            record_drop(it->second->message_id, DropReason::Incomplete);
+            it = chunk_streams_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SubscriberBus::record_drop(uint64_t message_id, DropReason reason) {
+    dropped_messages_.fetch_add(1, std::memory_order_relaxed);
+    flight_recorder_.record(FlightEventType::Drop, message_id, static_cast<uint64_t>(reason));
+}
+
+void SubscriberBus::dispatch(size_t lane, Executor::Task task, size_t affinity) {
+    if (urgent_lanes_.empty()) {
+        executor_->post(std::move(task), affinity);
+        return;
+    }
+    
+    // bulk work keeps its worker affinity and only yields to urgent work
+    // that was queued before it started
+    if (lane == default_lane(config_)) {
+        executor_->post([this, task = std::move(task)]() {
+            if (urgent_pending_.load(std::memory_order_acquire) > 0) {
+                run_urgent_pending();
+            }
+            task();
+        }, affinity);
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(urgent_lanes_[lane].mutex);
+        urgent_lanes_[lane].tasks.push_back(std::move(task));
+    }
+    urgent_pending_.fetch_add(1, std::memory_order_release);
+    executor_->post([this]() { run_urgent_pending(); }, affinity);
+}
+
+void SubscriberBus::run_urgent_pending() {
+    while (urgent_pending_.load(std::memory_order_acquire) > 0) {
+        Executor::Task task;
+        for (auto& urgent : urgent_lanes_) {
+            std::lock_guard<std::mutex> lock(urgent.mutex);
+            if (!urgent.tasks.empty()) {
+                task = std::move(urgent.tasks.front());
+                urgent.tasks.pop_front();
+                break;
+            }
+        }
         
+        // another worker took the last one between the count and the lock
+        if (!task) {
+            return;
+        }
+        urgent_pending_.fetch_sub(1, std::memory_order_relaxed);
+        task();
+    }
+}
+
+bool SubscriberBus::dump_flight_recorder(const std::string& path) const {
+    return flight_recorder_.dump(path, config_.subscriber_id);
+}
+
+void SubscriberBus::process_message(const Message& msg) {
+    record_received(msg.payload, 1);
+    
+    flight_recorder_.record(FlightEventType::HandlerStart, msg.trace.produce_ticks);
+    if (handler_) {
+        handler_(msg);
+    }
+    flight_recorder_.record(FlightEventType::HandlerEnd, msg.trace.produce_ticks);
+    
+    record_completed(msg.trace, 1);
+}
+
+void SubscriberBus::process_batch(Batch& batch) {
+    const uint64_t dequeue_ticks = TscClock::now();
+    for (auto& view : batch.views) {
+        view.trace.dequeue_ticks = dequeue_ticks;
+    }
+    
+    // metrics are per batch: the oldest message stands in for the rest
+    const MessageView& oldest = batch.views.front();
+    record_received(oldest.payload, batch.views.size());
+    
+    flight_recorder_.record(FlightEventType::HandlerStart, oldest.trace.produce_ticks, batch.views.size());
+    batch_handler_(std::span<const MessageView>(batch.views));
+    flight_recorder_.record(FlightEventType::HandlerEnd, oldest.trace.produce_ticks, batch.views.size());
+    
+    for (auto& msg : batch.reassembled) {
+        buffer_pool_.release(std::move(msg.payload));
+    }
+    
+    record_completed(oldest.trace, batch.views.size());
+}
+
+void SubscriberBus::record_received(std::string_view sample_payload, uint64_t count) {
+    metrics_.record_messages_processed(count);
+    
+    // "<steady_clock ns>|..." prefix written by pub_mt; binary payloads (e.g.
+    // Channel<T>) may contain '|' anywhere, so only accept a decimal prefix
+    const std::string_view head = sample_payload.substr(0, kMaxTimestampDigits + 1);
+    const size_t pipe_pos = head.find('|');
+    uint64_t ts = 0;
+    const auto parsed = pipe_pos != std::string_view::npos && pipe_pos > 0
+        ? std::from_chars(head.data(), head.data() + pipe_pos, ts)
+        : std::from_chars_result{head.data(), std::errc::invalid_argument};
+    if (parsed.ec == std::errc() && parsed.ptr == head.data() + pipe_pos) {
         auto now = std::chrono::steady_clock::now();
         auto msg_time = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(ts));
         auto latency = now - msg_time;
         
         metrics_.record_latency(latency);
     }
+}
+
+void SubscriberBus::record_completed(const MessageTrace& trace, uint64_t count) {
+    const uint64_t done_ticks = TscClock::now();
+    // missing or out-of-order stamps come back negative and Metrics skips them
+    metrics_.record_stage_latencies({
+        TscClock::elapsed(trace.produce_ticks, trace.forward_ticks),
+        TscClock::elapsed(trace.forward_ticks, trace.receive_ticks),
+        TscClock::elapsed(trace.receive_ticks, trace.dequeue_ticks),
+        TscClock::elapsed(trace.dequeue_ticks, done_ticks),
+    });
     
-    if (handler_) {
-        handler_(msg);
-    }
+    completed_messages_.fetch_add(count, std::memory_order_release);
 }
 
 } // namespace messenger
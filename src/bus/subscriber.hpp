@@ -2,12 +2,19 @@
 
 #include "types.hpp"
 #include "metrics.hpp"
+#include "executor.hpp"
+#include "lanes.hpp"
+#include "flight_recorder.hpp"
+#include "reassembly.hpp"
 #include <zmq.hpp>
 #include <zmq_addon.hpp>
-#include <boost/asio.hpp>
 #include <thread>
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
 #include <vector>
 
 namespace messenger {
@@ -16,41 +23,168 @@ namespace messenger {
  * SubscriberBus implements the subscriber side of the messaging bus.
  * 
  * Architecture:
- * - I/O thread: Owns SUB socket, receives messages, posts to worker pool
- * - Worker pool: Boost.Asio thread_pool for CPU-intensive message processing
+ * - I/O thread: Owns a SUB socket per priority lane, always receives from the
+ *   highest-priority non-empty lane first, posts to worker pool
+ * - Readiness: subscribes to its readiness topic last and treats the
+ *   publisher's echo on it as proof that the subscription is live
+ * - Workers: pluggable Executor for CPU-intensive message processing
+ *   (Boost.Asio thread_pool or work-stealing, see BusConfig::scheduler);
+ *   with several lanes, urgent-lane messages wait in per-lane queues that
+ *   every worker task drains first, while bulk tasks keep their affinity
+ * - Optional credit-based flow control: the I/O thread grants the publisher
+ *   credit from the real worker backlog over a PUSH socket
+ * - Fragmented messages are reassembled by the I/O thread into pooled
+ *   buffers, or streamed to a ChunkHandler in order, one chunk at a time
  * - No heavy work in I/O thread to maintain low latency
  */
 class SubscriberBus {
 public:
     SubscriberBus(const BusConfig& config, const std::vector<std::string>& topics, MessageHandler handler);
+    
+    // Runs handlers on a caller-supplied executor instead of BusConfig::scheduler
+    SubscriberBus(const BusConfig& config, const std::vector<std::string>& topics, MessageHandler handler,
+                  std::unique_ptr<Executor> executor);
+    
+    // Batch mode: each worker call gets every message the I/O thread had
+    // available, bounded by BusConfig::batch_max_messages / batch_max_delay
+    SubscriberBus(const BusConfig& config, const std::vector<std::string>& topics, BatchHandler handler);
+    
+    SubscriberBus(const BusConfig& config, const std::vector<std::string>& topics, BatchHandler handler,
+                  std::unique_ptr<Executor> executor);
     ~SubscriberBus();
     
+    // With BusConfig::await_ready, returns once the publisher acknowledged the
+    // subscription, or after ready_timeout if no publisher answered
     void start();
     
     void stop();
     
     bool is_running() const { return running_.load(); }
     
+    // True once the readiness handshake with the publisher completed
+    bool is_ready() const { return ready_.load(); }
+    
+    bool wait_ready(std::chrono::milliseconds timeout);
+    
+    const std::string& subscriber_id() const { return config_.subscriber_id; }
+    
+    // Fault injection: while paused the I/O thread stops reading its sockets
+    void set_io_paused(bool paused) { io_paused_.store(paused); }
+    
+    // Streams fragmented messages to `handler` chunk by chunk instead of
+    // reassembling them; must be called before start()
+    void set_chunk_handler(ChunkHandler handler) { chunk_handler_ = std::move(handler); }
+    
     Metrics::Stats get_metrics() { return metrics_.get_stats(); }
+    
+    // Messages read off the SUB sockets (fragmented ones once complete) and
+    // messages whose handler finished, since the last start()
+    uint64_t received_messages() const { return received_messages_.load(std::memory_order_relaxed); }
+    uint64_t completed_messages() const { return completed_messages_.load(std::memory_order_acquire); }
+    
+    // Fragmented messages given up on since the last start(): incomplete or
+    // above reassembly_max_size; each one is also a flight recorder drop
+    uint64_t dropped_messages() const { return dropped_messages_.load(std::memory_order_relaxed); }
+    
+    // Writes the flight recorder's recent events (see FlightRecorder)
+    bool dump_flight_recorder(const std::string& path) const;
 
 private:
     void io_thread_loop();
     
+    // Receives and dispatches one message from the lane; returns true if one was read
+    bool receive_one(size_t lane);
+    
+    // Receives and dispatches a batch from the lane; returns true if anything was read
+    bool receive_batch(size_t lane);
+    
+    // Consumes readiness echoes; returns true if the frames were one
+    bool handle_ready_echo(size_t lane, const std::vector<zmq::message_t>& msgs);
+    
+    struct Batch;
+    struct ChunkStream;
+    
+    // Reassembles or streams one chunk; in batch mode completed messages join `batch`
+    void receive_fragment(size_t lane, std::vector<zmq::message_t>& msgs, const FragmentHeader& fragment,
+                          uint64_t receive_ticks, Batch* batch);
+    
+    void stream_chunk(size_t lane, std::vector<zmq::message_t>& msgs, const FragmentHeader& fragment,
+                      const MessageTrace& trace);
+    
+    // Runs the stream's queued chunks in order; at most one task per stream runs it
+    void run_chunk_stream(ChunkStream& stream);
+    
+    // Drops fragmented messages whose chunks stopped arriving
+    void expire_fragments();
+    
+    void record_drop(uint64_t message_id, DropReason reason);
+    
+    void dispatch(size_t lane, Executor::Task task, size_t affinity);
+    
+    // Runs queued urgent-lane tasks, highest-priority lane first, until none are left
+    void run_urgent_pending();
+    
+    // Sends a credit grant when enough work completed or credit_period elapsed
+    void maybe_grant_credit();
+    
     void process_message(const Message& message);
     
+    void process_batch(Batch& batch);
+    
+    // Before the handler: throughput and end-to-end latency from the payload timestamp
+    void record_received(std::string_view sample_payload, uint64_t count);
+    
+    // After the handler: stage latencies and the completed count
+    void record_completed(const MessageTrace& sample_trace, uint64_t count);
+    
     BusConfig config_;
+    FlightRecorder flight_recorder_;
     std::vector<std::string> topics_;
     MessageHandler handler_;
+    BatchHandler batch_handler_;
+    ChunkHandler chunk_handler_;
     
     zmq::context_t context_;
-    std::unique_ptr<zmq::socket_t> sub_socket_;
+    std::vector<std::unique_ptr<zmq::socket_t>> sub_sockets_;  // indexed by lane
+    std::string ready_topic_;  // new nonce every start()
+    std::vector<bool> lane_ready_;  // I/O thread only
+    
+    // flow control; the counters below are cumulative for the lifetime of credit_epoch_
+    std::unique_ptr<zmq::socket_t> credit_socket_;
+    uint64_t credit_epoch_ = 0;
+    uint64_t last_granted_completed_ = 0;
+    uint64_t last_grant_ticks_ = 0;
+    
+    std::atomic<uint64_t> received_messages_{0};  // written by the I/O thread only
+    std::atomic<uint64_t> completed_messages_{0};
+    std::atomic<uint64_t> dropped_messages_{0};  // written by the I/O thread only
+    
+    std::atomic<bool> ready_{false};
+    std::mutex ready_mutex_;
+    std::condition_variable ready_cv_;
     
     std::atomic<bool> running_{false};
+    std::atomic<bool> io_paused_{false};
     std::thread io_thread_;
-    boost::asio::thread_pool worker_pool_;
+    std::unique_ptr<Executor> executor_;
+    
+    // urgent-lane backlog, indexed by lane; empty with a single lane. Bulk
+    // tasks are posted directly and only check urgent_pending_ before running
+    struct UrgentLane {
+        std::mutex mutex;
+        std::deque<Executor::Task> tasks;
+    };
+    std::vector<UrgentLane> urgent_lanes_;
+    std::atomic<size_t> urgent_pending_{0};
     
     Metrics metrics_;
     
+    // fragmented messages; the map and reassembler are I/O thread only
+    BufferPool buffer_pool_;
+    Reassembler reassembler_;
+    std::unordered_map<uint64_t, std::shared_ptr<ChunkStream>> chunk_streams_;  // by stream_id
+    uint64_t last_fragment_expiry_ticks_ = 0;
+    
     std::chrono::steady_clock::time_point start_time_;
 };
 
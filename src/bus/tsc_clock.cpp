@@ -0,0 +1,47 @@
+#include "tsc_clock.hpp"
+
+#ifdef MESSENGER_HAS_RDTSC
+#include <cpuid.h>
+#endif
+
+namespace messenger {
+
+namespace {
+#ifdef MESSENGER_HAS_RDTSC
+bool has_invariant_tsc() {
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) {
+        return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+}
+#endif
+}
+
+TscClock::Calibration TscClock::calibrate() noexcept {
+    Calibration result;
+#ifdef MESSENGER_HAS_RDTSC
+    if (!has_invariant_tsc()) {
+        return result;
+    }
+
+    // spin for a short window and fit ticks against steady_clock
+    const auto window = std::chrono::milliseconds(10);
+    const uint64_t start_ns = steady_ns();
+    const uint64_t start_ticks = __rdtsc();
+    uint64_t end_ns = start_ns;
+    while (end_ns - start_ns < static_cast<uint64_t>(std::chrono::nanoseconds(window).count())) {
+        end_ns = steady_ns();
+    }
+    const uint64_t end_ticks = __rdtsc();
+
+    if (end_ticks > start_ticks) {
+        result.use_tsc = true;
+        result.ns_per_tick = static_cast<double>(end_ns - start_ns) / static_cast<double>(end_ticks - start_ticks);
+    }
+#endif
+    return result;
+}
+
+} // namespace messenger
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MESSENGER_HAS_RDTSC 1
+#endif
+
+namespace messenger {
+
+/**
+ * Low-overhead timestamp source for per-stage latency tracing.
+ *
+ * now() returns raw ticks: the invariant TSC on x86 (a single rdtsc, much
+ * cheaper than steady_clock::now()), or steady_clock nanoseconds elsewhere.
+ * The TSC is shared by every core and process on a host, so tick deltas are
+ * comparable across the publisher and subscriber processes; elapsed() turns
+ * a delta into nanoseconds using a one-time calibration against steady_clock.
+ */
+class TscClock {
+public:
+    static uint64_t now() noexcept {
+#ifdef MESSENGER_HAS_RDTSC
+        if (calibration().use_tsc) {
+            return __rdtsc();
+        }
+#endif
+        return steady_ns();
+    }
+
+    // Returns a negative duration when either stamp is missing or `to` is not
+    // after `from` (TSC skew between cores or sockets), so callers can tell it
+    // apart from a real interval
+    static std::chrono::nanoseconds elapsed(uint64_t from, uint64_t to) noexcept {
+        if (from == 0 || to <= from) {
+            return std::chrono::nanoseconds(-1);
+        }
+        return std::chrono::nanoseconds(
+            static_cast<int64_t>(static_cast<double>(to - from) * calibration().ns_per_tick));
+    }
+
+    // Runs the one-time calibration (a ~10 ms spin) now rather than inside the
+    // first stamp; the buses call it from their constructors
+    static void calibrate_now() noexcept { calibration(); }
+
+    static bool uses_tsc() noexcept { return calibration().use_tsc; }
+    
+    static double ns_per_tick() noexcept { return calibration().ns_per_tick; }
+
+private:
+    struct Calibration {
+        bool use_tsc = false;
+        double ns_per_tick = 1.0;
+    };
+
+    static const Calibration& calibration() noexcept {
+        static const Calibration calibration = calibrate();
+        return calibration;
+    }
+
+    static Calibration calibrate() noexcept;
+
+    static uint64_t steady_ns() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+};
+
+} // namespace messenger
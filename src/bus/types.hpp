@@ -1,19 +1,53 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <span>
 #include <vector>
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <utility>
 
 namespace messenger {
 
+// TscClock ticks at each pipeline stage; 0 means the stage was not stamped
+struct MessageTrace {
+    uint64_t produce_ticks = 0;
+    uint64_t forward_ticks = 0;
+    uint64_t receive_ticks = 0;
+    uint64_t dequeue_ticks = 0;
+};
+
 struct Message {
     std::string topic;
     std::string payload;
+    MessageTrace trace;
     
     Message(std::string topic, std::string payload) 
-        : topic(topic), payload(payload) {}
+        : topic(std::move(topic)), payload(std::move(payload)) {}
+};
+
+enum class WorkerScheduler {
+    ThreadPool,    // boost::asio::thread_pool with one shared queue
+    WorkStealing   // per-worker Chase-Lev deques with stealing
+};
+
+/**
+ * A priority class. Topics starting with one of `topic_prefixes` get their own
+ * ingress queue, PUB/SUB socket pair and worker queue, and are always serviced
+ * before lower lanes. The publisher and subscribers must agree on the lanes.
+ */
+struct PriorityLane {
+    std::vector<std::string> topic_prefixes;
+    std::string pub_bind_addr;
+    std::string sub_connect_addr;
+};
+
+enum class FlowControlMode {
+    None,      // ZeroMQ HWMs only; overload drops silently
+    Throttle,  // produce() waits for credit, up to flow_control_timeout
+    Reject     // produce() fails immediately when a required subscriber is out of credit
 };
 
 struct BusConfig {
@@ -23,12 +57,87 @@ struct BusConfig {
     
     int io_threads = 1;
     int worker_threads = 4;
+    WorkerScheduler scheduler = WorkerScheduler::ThreadPool;
+    
+    // Batch handler mode: the I/O thread hands a worker every message already
+    // received, stopping at this many messages (0 counts as 1) or this long
+    // after the first
+    size_t batch_max_messages = 256;
+    std::chrono::microseconds batch_max_delay{50};
     
     std::chrono::milliseconds metrics_period{1000};
     
     int hwm = 1000;
+    
+    // Highest priority first; topics matching no lane use the lowest-priority
+    // default lane on pub_bind_addr / sub_connect_addr
+    std::vector<PriorityLane> priority_lanes;
+    
+    // Attach a WireHeader with TscClock stamps to every produced message
+    bool stage_timestamps = true;
+    
+    // Payloads above fragment_threshold bytes are sent as fragment_size chunks
+    // (0 disables); subscribers reassemble them into pooled buffers
+    size_t fragment_threshold = 1024 * 1024;
+    size_t fragment_size = 64 * 1024;
+    // Subscriber side: larger or stalled messages are discarded
+    size_t reassembly_max_size = 256 * 1024 * 1024;
+    std::chrono::milliseconds reassembly_timeout{5000};
+    // Reassembly buffers kept for reuse
+    size_t reassembly_pool_buffers = 8;
+    
+    // Flight recorder: recent events kept per thread (0 disables) and the file
+    // prefix of dumps requested through FlightRecorder::install_signal_handler()
+    size_t flight_recorder_events = 4096;
+    std::string flight_recorder_path = "bus-flight";
+    
+    // Readiness handshake: identity announced by a subscriber (generated when empty)
+    std::string subscriber_id;
+    // PublisherBus::start() waits for this many ready subscribers...
+    size_t await_subscribers = 0;
+    // ...or for exactly these subscriber ids
+    std::vector<std::string> await_subscriber_ids;
+    // SubscriberBus::start() waits for the publisher's echo; otherwise it returns
+    // at once and wait_ready() / is_ready() report the handshake
+    bool await_ready = false;
+    // Upper bound on how long start() waits for the handshake
+    std::chrono::milliseconds ready_timeout{1000};
+    
+    // Credit-based flow control: subscribers grant credit from their real
+    // worker backlog and the publisher gates produce() per topic on it
+    FlowControlMode flow_control = FlowControlMode::None;
+    std::string credit_bind_addr = "tcp://*:5557";
+    std::string credit_connect_addr = "tcp://127.0.0.1:5557";
+    // Messages a subscriber accepts beyond those it completed; keep below hwm
+    uint64_t credit_window = 1000;
+    // Longest interval between grants from an idle subscriber
+    std::chrono::milliseconds credit_period{10};
+    // Subscribers without grants for this long stop gating produce(), unless required
+    std::chrono::milliseconds credit_expiry{1000};
+    // Subscribers that gate produce(); empty means every subscriber sending grants
+    std::vector<std::string> credit_required_subscribers;
+    std::chrono::milliseconds flow_control_timeout{100};
+};
+
+// Borrowed view of a received message; valid only during the handler call
+struct MessageView {
+    std::string_view topic;
+    std::string_view payload;
+    MessageTrace trace;
+};
+
+// One chunk of a fragmented message; valid only during the handler call
+struct ChunkView {
+    std::string_view topic;
+    std::string_view data;
+    uint64_t stream_id = 0;   // same for every chunk of one message
+    uint64_t offset = 0;      // of `data` within the whole payload
+    uint64_t total_size = 0;
+    bool last = false;
 };
 
 using MessageHandler = std::function<void(const Message&)>;
+using BatchHandler = std::function<void(std::span<const MessageView>)>;
+using ChunkHandler = std::function<void(const ChunkView&)>;
 
-} // namespace messenger
\ No newline at end of file
+} // namespace messenger
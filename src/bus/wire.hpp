@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace messenger {
+
+/**
+ * On-the-wire layouts shared by PublisherBus and SubscriberBus.
+ *
+ * A bus message is [topic][payload] optionally followed by a fixed-size
+ * WireHeader frame. Frames are exchanged between processes on one host built
+ * from the same tree, so the header uses native layout and byte order.
+ */
+constexpr uint32_t kWireVersion = 1;
+
+struct WireHeader {
+    uint32_t version = kWireVersion;
+    uint32_t flags = 0;
+    uint64_t produce_ticks = 0;  // stamped by produce()
+    uint64_t forward_ticks = 0;  // stamped by the publisher I/O thread
+};
+
+static_assert(std::is_trivially_copyable_v<WireHeader>);
+
+/**
+ * Fragmentation: payloads above BusConfig::fragment_threshold travel as
+ * [topic][chunk][WireHeader][FragmentHeader] messages, one per chunk, with
+ * kWireFlagFragment set. The WireHeader is sent even with stage_timestamps
+ * off (its stamps are 0 then). Chunks of one message leave a producer in
+ * order, so other producers' traffic interleaves between them.
+ */
+constexpr uint32_t kWireFlagFragment = 1u << 0;
+
+struct FragmentHeader {
+    uint64_t stream_id = 0;   // unique per fragmented message and publisher
+    uint64_t total_size = 0;  // reassembled payload size
+    uint64_t offset = 0;      // of this chunk within the payload
+    uint32_t index = 0;
+    uint32_t count = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<FragmentHeader>);
+
+// Prefix of every Channel<T> payload, followed directly by the T bytes
+struct ChannelHeader {
+    uint64_t type_tag = 0;  // Channel<T>::type_tag of the sender
+    uint32_t size = 0;      // sizeof(T) on the sender
+    uint32_t reserved = 0;
+};
+
+static_assert(sizeof(ChannelHeader) == 16, "keeps the value 8-byte aligned in the payload");
+
+/**
+ * Credit grant sent by a subscriber on the flow-control channel as
+ * [subscriber_id][CreditGrant][topic prefix]... The subscriber may receive
+ * messages up to `granted` (cumulative since `epoch` started).
+ */
+struct CreditGrant {
+    uint64_t epoch = 0;      // changes whenever the subscriber restarts
+    uint64_t granted = 0;    // completed + credit_window
+    uint64_t received = 0;   // messages taken off the SUB sockets so far
+    uint64_t completed = 0;  // messages whose handler finished
+};
+
+static_assert(std::is_trivially_copyable_v<CreditGrant>);
+
+/**
+ * Readiness handshake: each SubscriberBus subscribes to its own readiness
+ * topic after its data topics. The publisher sees that subscription on its
+ * XPUB socket, which proves the data subscriptions before it have arrived,
+ * records the subscriber as ready and echoes an empty message on the same
+ * topic so the subscriber knows its connection is live.
+ *
+ * The topic carries the subscriber id and a nonce drawn at every start(), so
+ * the late unsubscribe of an earlier instance with the same id only clears
+ * that instance's readiness.
+ */
+inline constexpr std::string_view kReadyTopicPrefix = "__bus.ready/";
+
+inline std::string ready_topic(const std::string& subscriber_id, const std::string& instance) {
+    return std::string(kReadyTopicPrefix) + subscriber_id + "/" + instance;
+}
+
+// Splits a readiness topic; the nonce follows the last '/' since ids may contain one
+inline bool parse_ready_topic(std::string_view topic, std::string_view& subscriber_id, std::string_view& instance) {
+    if (topic.substr(0, kReadyTopicPrefix.size()) != kReadyTopicPrefix) {
+        return false;
+    }
+    topic.remove_prefix(kReadyTopicPrefix.size());
+    const size_t separator = topic.rfind('/');
+    if (separator == std::string_view::npos) {
+        return false;
+    }
+    subscriber_id = topic.substr(0, separator);
+    instance = topic.substr(separator + 1);
+    return true;
+}
+
+} // namespace messenger
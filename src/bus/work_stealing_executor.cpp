@@ -0,0 +1,163 @@
+#include "work_stealing_executor.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace messenger {
+
+namespace {
+// roughly a few microseconds of polling before a worker parks
+constexpr int kSpinIterations = 2048;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+}
+
+WorkStealingExecutor::WorkStealingExecutor(size_t workers) {
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    
+    threads_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        threads_.emplace_back(&WorkStealingExecutor::worker_loop, this, i);
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    join();
+}
+
+void WorkStealingExecutor::post(Task task, size_t affinity) {
+    TaskNode* node = acquire_node();
+    node->task = std::move(task);
+    auto& deque = workers_[affinity % workers_.size()]->deque;
+    deque.push(node);
+    
+    // pairs with the sleepers_ increment in worker_loop: either the worker sees
+    // the new task on its re-check, or we see it parked and wake it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    // the fence also orders a grow() in push() before this load: a worker that
+    // unparks after we read parked_ sees the new buffer (see worker_loop)
+    if (deque.has_retired() && parked_.load(std::memory_order_acquire) == workers_.size()) {
+        deque.reclaim();
+    }
+    
+    if (sleepers_.load(std::memory_order_relaxed) > 0) {
+        wake_epoch_.fetch_add(1, std::memory_order_release);
+        wake_epoch_.notify_one();
+    }
+}
+
+void WorkStealingExecutor::join() {
+    if (threads_.empty()) {
+        return;
+    }
+    
+    stopping_.store(true, std::memory_order_seq_cst);
+    wake_epoch_.fetch_add(1, std::memory_order_release);
+    wake_epoch_.notify_all();
+    
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+    
+    for (auto& worker : workers_) {
+        worker->deque.reclaim();
+    }
+}
+
+WorkStealingExecutor::TaskNode* WorkStealingExecutor::acquire_node() {
+    if (free_nodes_ == nullptr) {
+        for (auto& worker : workers_) {
+            free_nodes_ = worker->returned_nodes.exchange(nullptr, std::memory_order_acquire);
+            if (free_nodes_ != nullptr) {
+                break;
+            }
+        }
+    }
+    
+    if (free_nodes_ == nullptr) {
+        nodes_.push_back(std::make_unique<TaskNode>());
+        return nodes_.back().get();
+    }
+    TaskNode* node = free_nodes_;
+    free_nodes_ = node->next;
+    return node;
+}
+
+void WorkStealingExecutor::release_node(size_t index, TaskNode* node) {
+    // drop the captures now rather than when the node is reused
+    node->task = nullptr;
+    
+    auto& returned = workers_[index]->returned_nodes;
+    node->next = returned.load(std::memory_order_relaxed);
+    while (!returned.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+WorkStealingExecutor::TaskNode* WorkStealingExecutor::find_task(size_t index) {
+    const size_t count = workers_.size();
+    for (size_t i = 0; i < count; ++i) {
+        auto& deque = workers_[(index + i) % count]->deque;
+        // a failed steal may just be a lost race, so retry while work remains
+        while (!deque.empty()) {
+            if (auto task = deque.steal()) {
+                return *task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void WorkStealingExecutor::worker_loop(size_t index) {
+    while (true) {
+        TaskNode* task = find_task(index);
+        
+        for (int spin = 0; task == nullptr && spin < kSpinIterations; ++spin) {
+            cpu_relax();
+            task = find_task(index);
+        }
+        
+        if (task == nullptr) {
+            // stop only once all deques are drained, like thread_pool::join()
+            if (stopping_.load(std::memory_order_acquire)) {
+                return;
+            }
+            
+            const uint32_t epoch = wake_epoch_.load(std::memory_order_acquire);
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            task = find_task(index);
+            if (task == nullptr && !stopping_.load(std::memory_order_seq_cst)) {
+                // no steal in flight until we leave parked_ again
+                parked_.fetch_add(1, std::memory_order_release);
+                wake_epoch_.wait(epoch, std::memory_order_acquire);
+                parked_.fetch_sub(1, std::memory_order_relaxed);
+                // pairs with the fence in post(): either post() saw us leave
+                // parked_, or the next steal loads the buffer it grew into
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            
+            if (task == nullptr) {
+                continue;
+            }
+        }
+        
+        task->task();
+        release_node(index, task);
+    }
+}
+
+} // namespace messenger
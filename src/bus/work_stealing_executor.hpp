@@ -0,0 +1,73 @@
+#pragma once
+
+#include "executor.hpp"
+#include "chase_lev_deque.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace messenger {
+
+/**
+ * Work-stealing executor for skewed handler costs.
+ *
+ * - One ChaseLevDeque per worker, fed by the I/O thread using the affinity
+ *   hint so a topic keeps hitting the same worker's caches
+ * - Idle workers take from their own deque first, then steal from the others
+ * - Workers spin briefly before parking on a futex-backed epoch counter, and
+ *   post() only issues a wake-up when someone is actually parked
+ * - Tasks travel in recycled nodes: workers hand finished nodes back through
+ *   a per-worker stack that post() drains, so steady-state posting does not
+ *   allocate beyond what the std::function itself needs
+ * - Deque buffers retired by growth are freed by post() while every worker
+ *   is parked, and by join()
+ */
+class WorkStealingExecutor : public Executor {
+public:
+    explicit WorkStealingExecutor(size_t workers);
+    ~WorkStealingExecutor() override;
+
+    void post(Task task, size_t affinity) override;
+
+    void join() override;
+
+private:
+    struct TaskNode {
+        Task task;
+        TaskNode* next = nullptr;
+    };
+
+    void worker_loop(size_t index);
+
+    // Own deque first, then every other deque starting after our own
+    TaskNode* find_task(size_t index);
+
+    // I/O thread only: a free node, allocated only when none came back yet
+    TaskNode* acquire_node();
+
+    // Worker `index` only: returns a node whose task has run
+    void release_node(size_t index, TaskNode* node);
+
+    struct alignas(64) Worker {
+        ChaseLevDeque<TaskNode*> deque;
+        // finished nodes pushed by this worker; post() takes the whole stack
+        alignas(64) std::atomic<TaskNode*> returned_nodes{nullptr};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    // every node ever allocated, and the ones free for post(); I/O thread only
+    std::vector<std::unique_ptr<TaskNode>> nodes_;
+    TaskNode* free_nodes_ = nullptr;
+
+    std::atomic<bool> stopping_{false};
+    alignas(64) std::atomic<uint32_t> wake_epoch_{0};
+    alignas(64) std::atomic<uint32_t> sleepers_{0};
+    // workers past their last steal and about to wait or waiting; when it equals
+    // the worker count no thief can hold a retired deque buffer
+    std::atomic<uint32_t> parked_{0};
+};
+
+} // namespace messenger